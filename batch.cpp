@@ -0,0 +1,476 @@
+#include "batch.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "bloom.h"
+#include "checkpoint.h"
+#include "diagnostics.h"
+#include "frozen.h"
+#include "frozenview.h"
+#include "hashindex.h"
+#include "hotcache.h"
+#include "latency.h"
+#include "lazy.h"
+#include "memory.h"
+#include "paging.h"
+#include "parallel.h"
+#include "persistent.h"
+#include "scapegoat.h"
+#include "tombstone.h"
+#include "stats.h"
+
+using namespace std;
+
+/*
+Batch commands, one per line with tab separated arguments:
+    add         word  meaning  category  synonym  synonym  synonym
+    modify      word  meaning|category|synonyms  value [value value]
+    search      word
+    show        word
+    delete      word
+    category    category
+    letter      letter
+    list
+    page        all|category|letter  [category|letter]  size  [cursor]
+    firstlast
+    count
+    stats
+    latency
+    diagnostics
+    memory
+    rebuild
+    lazy
+    bloom       [false positive rate|off]
+    hotcache    [slots|off]
+    hashindex   [on|off]
+    scapegoat   [alpha|off]
+    tombstones  [ratio|off|compact]
+    snapshots   [on|off]
+    threads     [count]
+    load        path
+    merge       path
+    save        path
+    freeze      path  [restart interval]  [plain]
+    checkpoint  [full|off|open manifest]
+    journal     [interval ms  [batch records]|sync|off]
+'category' and 'count' run on 'threads' threads (default 1).
+'load' keeps the entries already in the dictionary; 'merge' replaces them with the file's.
+'checkpoint' writes the changes since the last one (see checkpoint.h); 'open' loads
+or starts the checkpoint at manifest. 'journal' also writes every change to the
+checkpoint's journal from a background thread (default batch 256, interval 0 for
+full batches only); 'sync' waits until the changes so far are on disk.
+'page' shows the next size entries (0 for all) of a listing after the cursor (empty
+for the first page) and prints the cursor to pass for the following page.
+With 'snapshots' on, 'list', 'save', 'freeze' and checkpoint base files write a
+snapshot of the dictionary taken when they start (see persistent.h).
+Blank lines and lines starting with '#' are ignored.
+*/
+// Loads a text or frozen dictionary file; returns -1 when it cannot be read.
+int loadDictionaryFile(Dictionary* dictionary, const string& path, DuplicatePolicy policy) {
+    ifstream in(path, ios::binary);
+    if (!in) {
+        return -1;
+    }
+    if (isFrozenFile(in)) {
+        return loadFrozenDictionary(dictionary, in, policy);
+    }
+    return loadDictionary(dictionary, in, policy);
+}
+
+// Parses a numeric argument; a bad one fails the command.
+template <typename T>
+static bool parseArgument(const string& text, T& value) {
+    if (parseNumber(text, value)) {
+        return true;
+    }
+    cout << "Invalid number: " << text << "\n";
+    return false;
+}
+
+static bool changesDictionary(const string& command) {
+    static const char* const changing[] = {"add", "modify", "delete", "load", "merge", "rebuild", "bloom",
+                                           "hotcache", "hashindex", "scapegoat", "tombstones", "snapshots",
+                                           "checkpoint", "journal"};
+    for (const char* name : changing) {
+        if (command == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The reading commands on a frozen dictionary; sets handled for the ones it serves.
+static bool runFrozenCommand(const FrozenDictionary& frozen, const string& command, vector<string>& args,
+                             bool& handled) {
+    handled = true;
+    if (changesDictionary(command)) {
+        cout << "The frozen dictionary is read-only.\n";
+        return false;
+    }
+    if (command == "search") {
+        LatencyTimer timer(LAT_SEARCH);
+        findFrozen(frozen, args[1]);
+    } else if (command == "show") {
+        LatencyTimer timer(LAT_SHOW);
+        if (!showFrozenWord(frozen, args[1])) {
+            cout << "Word not found.\n";
+        }
+    } else if (command == "category") {
+        LatencyTimer timer(LAT_LIST_CATEGORY);
+        listFrozenByCategory(frozen, args[1]);
+    } else if (command == "letter") {
+        if (args[1].empty()) {
+            return false;
+        }
+        LatencyTimer timer(LAT_LIST_LETTER);
+        listFrozenByLetter(frozen, args[1][0]);
+    } else if (command == "list") {
+        LatencyTimer timer(LAT_LIST_ALL);
+        listAllFrozen(frozen);
+    } else if (command == "firstlast") {
+        LatencyTimer timer(LAT_FIRST_LAST);
+        showFrozenFirstAndLast(frozen);
+    } else if (command == "count") {
+        LatencyTimer timer(LAT_COUNT);
+        cout << "Number of words in the dictionary: " << frozen.count << "\n";
+    } else if (command == "save") {
+        ofstream out(args[1]);
+        if (!out) {
+            cout << "Cannot open " << args[1] << "\n";
+            return false;
+        }
+        saveFrozenAsText(frozen, out);
+    } else if (command == "freeze") {
+        // Refreezing changes the restart interval or the meaning compression.
+        vector<WordEntry> entries;
+        entries.reserve(frozen.count);
+        forEachFrozen(frozen, 0, [&entries](const WordEntry& entry) {
+            entries.push_back(entry);
+            return true;
+        });
+        vector<const WordEntry*> sorted;
+        sorted.reserve(entries.size());
+        for (const WordEntry& entry : entries) {
+            sorted.push_back(&entry);
+        }
+        uint32_t restartInterval = 16;
+        if (!args[2].empty() && !parseArgument(args[2], restartInterval)) {
+            return false;
+        }
+        ofstream out(args[1], ios::binary);
+        if (!out) {
+            cout << "Cannot open " << args[1] << "\n";
+            return false;
+        }
+        FrozenDictionary refrozen = freezeEntries(sorted, restartInterval, args[3] != "plain");
+        saveFrozen(refrozen, out);
+        printFrozenStats(refrozen, cout);
+    } else if (command == "memory") {
+        printFrozenStats(frozen, cout);
+    } else {
+        handled = false;
+    }
+    return true;
+}
+
+bool runCommand(Dictionary* dictionary, const string& line) {
+    if (line.empty() || line[0] == '#') {
+        return true;
+    }
+    vector<string> args = splitFields(line, '\t');
+    string command = args[0];
+    args.resize(7);
+
+    if (dictionary->frozen != nullptr) {
+        bool handled;
+        bool succeeded = runFrozenCommand(*dictionary->frozen, command, args, handled);
+        if (handled) {
+            return succeeded;
+        }
+    }
+
+    if (command == "add") {
+        LatencyTimer timer(LAT_ADD);
+        if (!emplaceWord(dictionary, move(args[1]), move(args[2]), move(args[3]), &args[4]).second) {
+            cout << "Word already exists in the dictionary.\n";
+        }
+    } else if (command == "modify") {
+        LatencyTimer timer(LAT_MODIFY);
+        Node* found = searchWord(dictionary, args[1]);
+        if (found == nullptr) {
+            cout << "Word not found.\n";
+            return true;
+        }
+        if (args[2] == "meaning") {
+            pinEntry(dictionary->lazy, found);
+            found->meaning = args[3];
+        } else if (args[2] == "category") {
+            found->grammaticalCategory = args[3];
+        } else if (args[2] == "synonyms") {
+            pinEntry(dictionary->lazy, found);
+            for (int i = 0; i < 3; i++) {
+                found->synonyms[i] = args[3 + i];
+            }
+        } else {
+            return false;
+        }
+        noteChange(dictionary, found->word, found);
+    } else if (command == "search") {
+        LatencyTimer timer(LAT_SEARCH);
+        searchWord(dictionary, args[1]);
+    } else if (command == "show") {
+        LatencyTimer timer(LAT_SHOW);
+        Node* found = searchWord(dictionary, args[1]);
+        if (found == nullptr) {
+            cout << "Word not found.\n";
+        } else {
+            showWord(found, dictionary->lazy);
+        }
+    } else if (command == "delete") {
+        LatencyTimer timer(LAT_DELETE);
+        deleteWord(dictionary, args[1]);
+    } else if (command == "category") {
+        LatencyTimer timer(LAT_LIST_CATEGORY);
+        parallelListByCategory(dictionary->root, args[1], dictionary->lazy);
+    } else if (command == "letter") {
+        if (args[1].empty()) {
+            return false;
+        }
+        LatencyTimer timer(LAT_LIST_LETTER);
+        listByLetter(dictionary->root, args[1][0], dictionary->lazy);
+    } else if (command == "list") {
+        LatencyTimer timer(LAT_LIST_ALL);
+        if (dictionary->versions != nullptr) {
+            forEachWord(takeSnapshot(dictionary), [](const WordEntry& entry) { showWord(entry); });
+        } else {
+            listAllWords(dictionary->root, dictionary->lazy);
+        }
+    } else if (command == "page") {
+        ListingKind kind;
+        LatencyOperation operation;
+        if (args[1] == "all") {
+            kind = LISTING_ALL;
+            operation = LAT_LIST_ALL;
+        } else if (args[1] == "category") {
+            kind = LISTING_CATEGORY;
+            operation = LAT_LIST_CATEGORY;
+        } else if (args[1] == "letter" && !args[2].empty()) {
+            kind = LISTING_LETTER;
+            operation = LAT_LIST_LETTER;
+        } else {
+            return false;
+        }
+        size_t pageSize;
+        if (!parseArgument(args[3], pageSize)) {
+            return false;
+        }
+        // 0 shows the whole listing, as --page-size 0 does.
+        if (pageSize == 0) {
+            pageSize = SIZE_MAX;
+        }
+        ListingCursor cursor = makeListingCursor(kind, args[2], args[4]);
+        LatencyTimer timer(operation);
+        if (dictionary->frozen != nullptr) {
+            showFrozenPage(*dictionary->frozen, cursor, pageSize);
+        } else {
+            showPage(dictionary->root, cursor, pageSize, dictionary->lazy);
+        }
+        if (cursor.finished) {
+            cout << "End of listing.\n";
+        } else {
+            cout << "Next cursor: " << cursor.after << "\n";
+        }
+    } else if (command == "firstlast") {
+        LatencyTimer timer(LAT_FIRST_LAST);
+        showFirstAndLast(dictionary->root, dictionary->lazy);
+    } else if (command == "count") {
+        LatencyTimer timer(LAT_COUNT);
+        cout << "Number of words in the dictionary: " << parallelCountWords(dictionary->root) << "\n";
+    } else if (command == "stats") {
+        printStats(cout);
+    } else if (command == "latency") {
+        printLatencyReport(cout);
+    } else if (command == "diagnostics") {
+        printTreeShape(analyzeTree(dictionary->root), cout);
+    } else if (command == "memory") {
+        printMemoryReport(measureMemory(dictionary), cout);
+    } else if (command == "rebuild") {
+        rebuildTree(dictionary);
+    } else if (command == "bloom") {
+        if (args[1] == "off") {
+            disableBloomFilter(dictionary);
+        } else if (!args[1].empty()) {
+            double value;
+            if (!parseArgument(args[1], value)) {
+                return false;
+            }
+            enableBloomFilter(dictionary, value);
+        }
+        printBloomStats(dictionary, cout);
+    } else if (command == "hotcache") {
+        if (args[1] == "off") {
+            disableHotCache(dictionary);
+        } else if (!args[1].empty()) {
+            size_t capacity;
+            if (!parseArgument(args[1], capacity)) {
+                return false;
+            }
+            enableHotCache(dictionary, capacity);
+        }
+        printHotCacheStats(dictionary, cout);
+    } else if (command == "hashindex") {
+        if (args[1] == "on") {
+            enableHashIndex(dictionary);
+        } else if (args[1] == "off") {
+            disableHashIndex(dictionary);
+        }
+        printHashIndexStats(dictionary, cout);
+    } else if (command == "scapegoat") {
+        if (args[1] == "off") {
+            disableScapegoat(dictionary);
+        } else if (!args[1].empty()) {
+            double value;
+            if (!parseArgument(args[1], value)) {
+                return false;
+            }
+            enableScapegoat(dictionary, value);
+        }
+        printScapegoatStats(dictionary, cout);
+    } else if (command == "tombstones") {
+        if (args[1] == "off") {
+            disableTombstones(dictionary);
+        } else if (args[1] == "compact") {
+            compactTombstones(dictionary);
+        } else if (!args[1].empty()) {
+            double value;
+            if (!parseArgument(args[1], value)) {
+                return false;
+            }
+            enableTombstones(dictionary, value);
+        }
+        printTombstoneStats(dictionary, cout);
+    } else if (command == "snapshots") {
+        if (args[1] == "on") {
+            enableSnapshots(dictionary);
+        } else if (args[1] == "off") {
+            disableSnapshots(dictionary);
+        }
+        printSnapshotStats(dictionary, cout);
+    } else if (command == "threads") {
+        if (!args[1].empty()) {
+            unsigned threads;
+            if (!parseArgument(args[1], threads)) {
+                return false;
+            }
+            setTraversalThreads(threads);
+        }
+        cout << "Traversal threads: " << traversalThreads() << "\n";
+    } else if (command == "lazy") {
+        printLazyStats(dictionary, cout);
+    } else if (command == "load" || command == "merge") {
+        int loaded = loadDictionaryFile(dictionary, args[1], command == "merge" ? REPLACE_EXISTING : KEEP_EXISTING);
+        if (loaded < 0) {
+            cout << "Cannot load " << args[1] << "\n";
+            return false;
+        }
+        cout << "Loaded " << loaded << " words.\n";
+    } else if (command == "save") {
+        if (isLazySource(dictionary, args[1])) {
+            cout << "Cannot overwrite the lazily loaded file " << args[1] << "\n";
+            return false;
+        }
+        ofstream out(args[1]);
+        if (!out) {
+            cout << "Cannot open " << args[1] << "\n";
+            return false;
+        }
+        if (dictionary->versions != nullptr) {
+            saveSnapshot(takeSnapshot(dictionary), out);
+        } else {
+            saveDictionary(dictionary->root, out, dictionary->lazy);
+        }
+    } else if (command == "freeze") {
+        if (isLazySource(dictionary, args[1])) {
+            cout << "Cannot overwrite the lazily loaded file " << args[1] << "\n";
+            return false;
+        }
+        uint32_t restartInterval = 16;
+        if (!args[2].empty() && !parseArgument(args[2], restartInterval)) {
+            return false;
+        }
+        ofstream out(args[1], ios::binary);
+        if (!out) {
+            cout << "Cannot open " << args[1] << "\n";
+            return false;
+        }
+        FrozenDictionary frozen;
+        if (dictionary->versions != nullptr) {
+            Snapshot snapshot = takeSnapshot(dictionary);
+            vector<const WordEntry*> entries;
+            forEachWord(snapshot, [&entries](const WordEntry& entry) { entries.push_back(&entry); });
+            frozen = freezeEntries(entries, restartInterval, args[3] != "plain");
+        } else {
+            frozen = freezeTree(dictionary->root, dictionary->lazy, restartInterval, args[3] != "plain");
+        }
+        saveFrozen(frozen, out);
+        printFrozenStats(frozen, cout);
+    } else if (command == "checkpoint") {
+        if (args[1] == "open") {
+            int loaded = openCheckpoint(dictionary, args[2]);
+            if (loaded < 0) {
+                cout << "Cannot open checkpoint " << args[2] << "\n";
+                return false;
+            }
+            cout << "Loaded " << loaded << " words.\n";
+        } else if (args[1] == "off") {
+            closeCheckpoint(dictionary);
+        } else if (!writeCheckpoint(dictionary, args[1] == "full")) {
+            cout << "Checkpoint failed.\n";
+            return false;
+        }
+        printCheckpointStats(dictionary, cout);
+    } else if (command == "journal") {
+        if (args[1] == "off") {
+            stopJournal(dictionary);
+        } else if (args[1] == "sync") {
+            if (!syncJournal(dictionary)) {
+                cout << "Journal sync failed.\n";
+                return false;
+            }
+        } else if (!args[1].empty()) {
+            unsigned interval;
+            size_t batchSize = 256;
+            if (!parseArgument(args[1], interval) || (!args[2].empty() && !parseArgument(args[2], batchSize))) {
+                return false;
+            }
+            if (!startJournal(dictionary, interval, batchSize)) {
+                cout << "Cannot start the journal; open a checkpoint first.\n";
+                return false;
+            }
+        }
+        printCheckpointStats(dictionary, cout);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int runBatch(Dictionary* dictionary, istream& in) {
+    int failed = 0;
+    int lineNumber = 0;
+    string line;
+    while (getline(in, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!runCommand(dictionary, line)) {
+            cerr << "line " << lineNumber << ": invalid command: " << line << "\n";
+            failed++;
+        }
+    }
+    return failed;
+}
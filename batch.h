@@ -0,0 +1,13 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <istream>
+#include <string>
+
+#include "dictionary.h"
+
+int loadDictionaryFile(Dictionary* dictionary, const std::string& path, DuplicatePolicy policy = KEEP_EXISTING);
+bool runCommand(Dictionary* dictionary, const std::string& line);
+int runBatch(Dictionary* dictionary, std::istream& in);
+
+#endif
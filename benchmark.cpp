@@ -0,0 +1,327 @@
+/*
+Benchmark suite for the dictionary.
+
+For every key distribution and dictionary size it measures:
+    insert      addWord for every key, in distribution order
+    search      searchWord over existing keys
+    category    full listByCategory traversals
+    letter      full listByLetter traversals
+    count       full countWords traversals
+    delete      deleteWord over distinct existing keys, in shuffled order
+                (in insertion order for sorted and reverse)
+
+Distributions:
+    random      keys inserted and accessed in shuffled order
+    sorted      keys inserted and accessed in ascending order
+    reverse     keys inserted and accessed in descending order
+    zipf        keys inserted in shuffled order, accessed with a Zipf(0.99) skew
+
+Each result is printed as one JSON object per line on stdout:
+    {"workload":"search","distribution":"zipf","n":1000,"ops":1000,"ops_per_sec":...,
+     "p50_ns":...,"p99_ns":...,"peak_rss_kb":...}
+Every case (distribution and size) runs in a forked process of its own, so
+peak_rss_kb is that case's peak resident size up to the end of the workload and
+never an earlier, larger case's.
+
+--threads runs the category and count workloads on the parallel traversal.
+
+Sorted and reverse insertion degenerate the tree into a list (quadratic build,
+recursion as deep as the dictionary), so those cases are skipped above
+--degenerate-limit.
+
+Usage: benchmark [--min-exp 3] [--max-exp 5] [--ops 100000] [--reps 5]
+                 [--degenerate-limit 10000] [--seed 42] [--dist random,sorted,reverse,zipf]
+                 [--threads 1]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "dictionary.h"
+#include "parallel.h"
+#include "trace.h"
+
+using namespace std;
+
+struct BenchConfig {
+    int minExp = 3;
+    int maxExp = 5;
+    size_t ops = 100000;
+    int reps = 5;
+    unsigned threads = 1;
+    size_t degenerateLimit = 10000;
+    unsigned seed = 42;
+    vector<string> distributions = {"random", "sorted", "reverse", "zipf"};
+};
+
+static const char* categories[] = {"noun", "verb", "adjective", "adverb", "other"};
+
+// Fixed-width base-26 spelling keeps keys distinct and in the same order as i.
+string benchKey(size_t i) {
+    string key(6, 'a');
+    for (int pos = 5; pos >= 0; pos--) {
+        key[pos] = (char) ('a' + i % 26);
+        i /= 26;
+    }
+    return key;
+}
+
+// Peak of the calling process only; runCaseInChild gives every case a fresh process.
+long peakRssKb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Rejection-inversion sampling (Hoermann and Derflinger) of ranks in [0, n) with
+// P(r) proportional to 1 / (r + 1)^s, in constant memory, so that the sampler adds
+// nothing to the case's peak_rss_kb. s must not be 1.
+class ZipfSampler {
+public:
+    ZipfSampler(size_t n, double s) : n(n), s(s) {
+        hIntegralFirst = hIntegral(1.5) - 1.0;
+        hIntegralLast = hIntegral((double) n + 0.5);
+        squeeze = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+    }
+
+    size_t operator()(mt19937_64& rng) {
+        uniform_real_distribution<double> uniform(0.0, 1.0);
+        while (true) {
+            double u = hIntegralLast + uniform(rng) * (hIntegralFirst - hIntegralLast);
+            double x = hIntegralInverse(u);
+            double k = clamp(floor(x + 0.5), 1.0, (double) n);
+            if (k - x <= squeeze || u >= hIntegral(k + 0.5) - h(k)) {
+                return (size_t) k - 1;
+            }
+        }
+    }
+
+private:
+    double h(double x) const { return exp(-s * log(x)); }
+
+    double hIntegral(double x) const {
+        double logX = log(x);
+        double t = (1.0 - s) * logX;
+        return (abs(t) > 1e-8 ? expm1(t) / t : 1.0 + t / 2.0) * logX;
+    }
+
+    double hIntegralInverse(double x) const {
+        double t = max(x * (1.0 - s), -1.0);
+        return exp((abs(t) > 1e-8 ? log1p(t) / t : 1.0 - t / 2.0) * x);
+    }
+
+    size_t n;
+    double s;
+    double hIntegralFirst;
+    double hIntegralLast;
+    double squeeze;
+};
+
+void report(ostream& out, const string& workload, const string& distribution, size_t n,
+            vector<uint64_t>& latencies, double totalSeconds) {
+    size_t ops = latencies.size();
+    uint64_t p50 = 0, p99 = 0;
+    if (ops > 0) {
+        size_t i50 = ops / 2;
+        size_t i99 = min(ops - 1, (size_t) (ops * 0.99));
+        nth_element(latencies.begin(), latencies.begin() + i50, latencies.end());
+        p50 = latencies[i50];
+        nth_element(latencies.begin(), latencies.begin() + i99, latencies.end());
+        p99 = latencies[i99];
+    }
+    double opsPerSec = totalSeconds > 0 ? ops / totalSeconds : 0;
+    out << "{\"workload\":\"" << workload << "\",\"distribution\":\"" << distribution
+        << "\",\"n\":" << n << ",\"ops\":" << ops << ",\"ops_per_sec\":" << (uint64_t) opsPerSec
+        << ",\"p50_ns\":" << p50 << ",\"p99_ns\":" << p99
+        << ",\"peak_rss_kb\":" << peakRssKb() << "}" << endl;
+}
+
+// Runs op(i) for every i in [0, count) and records each call's latency.
+template <typename Op>
+void timeOps(ostream& out, const string& workload, const string& distribution, size_t n, size_t count, Op op) {
+    vector<uint64_t> latencies(count);
+    auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        auto start = chrono::steady_clock::now();
+        op(i);
+        auto stop = chrono::steady_clock::now();
+        latencies[i] = (uint64_t) chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
+    }
+    double total = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    report(out, workload, distribution, n, latencies, total);
+}
+
+void runCase(ostream& out, const BenchConfig& config, const string& distribution, size_t n) {
+    mt19937_64 rng(config.seed ^ n);
+
+    vector<size_t> insertOrder(n);
+    for (size_t i = 0; i < n; i++) {
+        insertOrder[i] = i;
+    }
+    if (distribution == "reverse") {
+        reverse(insertOrder.begin(), insertOrder.end());
+    } else if (distribution != "sorted") {
+        shuffle(insertOrder.begin(), insertOrder.end(), rng);
+    }
+
+    size_t accessCount = min(n, config.ops);
+    vector<size_t> accessOrder(accessCount);
+    if (distribution == "zipf") {
+        // Rank r maps to a shuffled key so hot keys are scattered over the tree.
+        ZipfSampler zipf(n, 0.99);
+        for (size_t i = 0; i < accessCount; i++) {
+            accessOrder[i] = insertOrder[zipf(rng)];
+        }
+    } else if (distribution == "random") {
+        uniform_int_distribution<size_t> pick(0, n - 1);
+        for (size_t i = 0; i < accessCount; i++) {
+            accessOrder[i] = pick(rng);
+        }
+    } else {
+        for (size_t i = 0; i < accessCount; i++) {
+            accessOrder[i] = insertOrder[i];
+        }
+    }
+
+    vector<string> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = benchKey(i);
+    }
+
+    Dictionary dictionary;
+    dictionary.root = nullptr;
+    string synonyms[3] = {"sinonimo", "parecido", "igual"};
+    string meaning = "significado de prueba para la palabra";
+
+    timeOps(out, "insert", distribution, n, n, [&](size_t i) {
+        size_t key = insertOrder[i];
+        addWord(&dictionary, keys[key], meaning, categories[key % 5], synonyms);
+    });
+
+    size_t found = 0;
+    timeOps(out, "search", distribution, n, accessCount, [&](size_t i) {
+        found += searchWord(dictionary.root, keys[accessOrder[i]]) != nullptr;
+    });
+    if (found != accessCount) {
+        cerr << "search: expected " << accessCount << " hits, got " << found << "\n";
+    }
+
+    timeOps(out, "category", distribution, n, config.reps, [&](size_t i) {
+        parallelListByCategory(dictionary.root, categories[i % 5], nullptr);
+    });
+
+    timeOps(out, "letter", distribution, n, config.reps, [&](size_t i) {
+        listByLetter(dictionary.root, (char) ('a' + i % 26), nullptr);
+    });
+
+    size_t counted = 0;
+    timeOps(out, "count", distribution, n, config.reps, [&](size_t) {
+        counted += parallelCountWords(dictionary.root);
+    });
+    if (counted != n * config.reps) {
+        cerr << "count: expected " << n * config.reps << ", got " << counted << "\n";
+    }
+
+    // Every key once, since deleting a key again would time a miss.
+    vector<size_t> deleteOrder = insertOrder;
+    if (distribution == "random" || distribution == "zipf") {
+        shuffle(deleteOrder.begin(), deleteOrder.end(), rng);
+    }
+    timeOps(out, "delete", distribution, n, accessCount, [&](size_t i) {
+        deleteWord(dictionary.root, keys[deleteOrder[i]], nullptr);
+    });
+
+    destroyTree(dictionary.root, nullptr);
+}
+
+// The pool's threads are started in the child, since fork copies only the calling thread.
+bool runCaseInChild(ostream& out, const BenchConfig& config, const string& distribution, size_t n) {
+    out.flush();
+    pid_t child = fork();
+    if (child < 0) {
+        return false;
+    }
+    if (child == 0) {
+        setTraversalThreads(config.threads);
+        runCase(out, config, distribution, n);
+        out.flush();
+        _exit(0);
+    }
+    int status = 0;
+    if (waitpid(child, &status, 0) != child) {
+        return false;
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+vector<string> splitList(const string& text) {
+    vector<string> items;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ',')) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        string value = argv[i + 1];
+        if (flag == "--min-exp") {
+            config.minExp = stoi(value);
+        } else if (flag == "--max-exp") {
+            config.maxExp = stoi(value);
+        } else if (flag == "--ops") {
+            config.ops = stoull(value);
+        } else if (flag == "--reps") {
+            config.reps = stoi(value);
+        } else if (flag == "--degenerate-limit") {
+            config.degenerateLimit = stoull(value);
+        } else if (flag == "--threads") {
+            config.threads = (unsigned) stoul(value);
+        } else if (flag == "--seed") {
+            config.seed = (unsigned) stoul(value);
+        } else if (flag == "--dist") {
+            config.distributions = splitList(value);
+        } else {
+            cerr << "Unknown option: " << flag << "\n";
+            return 1;
+        }
+    }
+
+    // Results go to the real stdout; the dictionary's own printing is discarded.
+    ostream out(cout.rdbuf());
+    NullBuffer nullBuffer;
+    cout.rdbuf(&nullBuffer);
+
+    for (const string& distribution : config.distributions) {
+        for (int exp = config.minExp; exp <= config.maxExp; exp++) {
+            size_t n = (size_t) pow(10.0, exp);
+            bool degenerate = distribution == "sorted" || distribution == "reverse";
+            if (degenerate && n > config.degenerateLimit) {
+                cerr << "skipping " << distribution << " n=" << n << " (above --degenerate-limit)\n";
+                continue;
+            }
+            if (!runCaseInChild(out, config, distribution, n)) {
+                cerr << distribution << " n=" << n << " failed\n";
+                return 1;
+            }
+        }
+    }
+
+    cout.rdbuf(out.rdbuf());
+    return 0;
+}
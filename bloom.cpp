@@ -0,0 +1,142 @@
+#include "bloom.h"
+
+#include <cmath>
+
+#include "dictionary.h"
+
+using namespace std;
+
+static const uint64_t blockWords = 8;
+static const uint64_t minimumCapacity = 1024;
+
+// Expected false positive rate of a blocked filter: the keys per block vary (Poisson),
+// and the fuller blocks raise the rate above that of a plain Bloom filter.
+static double blockedFalsePositiveRate(double bitsPerKey, int hashes) {
+    double blockBits = (double) (blockWords * 64);
+    double mean = blockBits / bitsPerKey;
+    double rate = 0;
+    double probability = exp(-mean);
+    for (int keys = 0; keys < mean + 10 * sqrt(mean) + 20; keys++) {
+        rate += probability * pow(1 - pow(1 - 1 / blockBits, (double) hashes * keys), hashes);
+        probability *= mean / (keys + 1);
+    }
+    return rate;
+}
+
+static void sizeFilter(BloomFilter* filter, uint64_t capacity) {
+    filter->capacity = capacity < minimumCapacity ? minimumCapacity : capacity;
+    double bitsPerKey = -log(filter->falsePositiveRate) / (log(2.0) * log(2.0));
+    filter->hashes = max(1, (int) round(bitsPerKey * log(2.0)));
+    while (blockedFalsePositiveRate(bitsPerKey, filter->hashes) > filter->falsePositiveRate) {
+        bitsPerKey *= 1.05;
+    }
+    uint64_t blocks = (uint64_t) ceil(filter->capacity * bitsPerKey / (blockWords * 64));
+    filter->bits.assign(max<uint64_t>(blocks, 1) * blockWords, 0);
+    filter->keys = 0;
+    filter->deletesSinceRebuild = 0;
+    filter->lookups = 0;
+    filter->rejected = 0;
+    filter->falsePositives = 0;
+}
+
+// The block comes from the high half of the hash.
+static uint64_t* blockOf(BloomFilter* filter, uint64_t hash) {
+    uint64_t blocks = filter->bits.size() / blockWords;
+    return &filter->bits[((hash >> 32) * blocks >> 32) * blockWords];
+}
+
+// Probes are 9-bit slices of remixes of the hash, seven per remix, so they depend
+// neither on the block nor on each other. Double hashing within 512 bits measured
+// twice the target rate at 0.001.
+static uint64_t remix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void bloomAdd(BloomFilter* filter, const string& word) {
+    uint64_t hash = hashWord(word);
+    uint64_t* block = blockOf(filter, hash);
+    uint64_t probes = 0;
+    for (int i = 0; i < filter->hashes; i++) {
+        if (i % 7 == 0) {
+            probes = remix(hash + i);
+        }
+        uint32_t bit = probes & 511;
+        probes >>= 9;
+        block[bit >> 6] |= 1ULL << (bit & 63);
+    }
+    filter->keys++;
+}
+
+bool bloomMayContain(BloomFilter* filter, const string& word) {
+    uint64_t hash = hashWord(word);
+    const uint64_t* block = blockOf(filter, hash);
+    uint64_t probes = 0;
+    filter->lookups++;
+    for (int i = 0; i < filter->hashes; i++) {
+        if (i % 7 == 0) {
+            probes = remix(hash + i);
+        }
+        uint32_t bit = probes & 511;
+        probes >>= 9;
+        if ((block[bit >> 6] & (1ULL << (bit & 63))) == 0) {
+            filter->rejected++;
+            return false;
+        }
+    }
+    return true;
+}
+
+void rebuildBloomFilter(Dictionary* dictionary) {
+    BloomFilter* filter = dictionary->filter;
+    vector<Node*> nodes;
+    flattenLiveTree(dictionary->root, nodes);
+    // Leave room to grow so a burst of inserts does not immediately force another rebuild.
+    sizeFilter(filter, nodes.size() * 2);
+    for (Node* node : nodes) {
+        bloomAdd(filter, node->word);
+    }
+}
+
+void enableBloomFilter(Dictionary* dictionary, double falsePositiveRate) {
+    if (dictionary->filter == nullptr) {
+        dictionary->filter = new BloomFilter();
+    }
+    dictionary->filter->falsePositiveRate = falsePositiveRate > 0 && falsePositiveRate < 1 ? falsePositiveRate : 0.01;
+    rebuildBloomFilter(dictionary);
+}
+
+void disableBloomFilter(Dictionary* dictionary) {
+    delete dictionary->filter;
+    dictionary->filter = nullptr;
+}
+
+void bloomNoteDelete(Dictionary* dictionary) {
+    BloomFilter* filter = dictionary->filter;
+    if (filter != nullptr && ++filter->deletesSinceRebuild * 10 > filter->keys) {
+        rebuildBloomFilter(dictionary);
+    }
+}
+
+void printBloomStats(const Dictionary* dictionary, ostream& out) {
+    const BloomFilter* filter = dictionary->filter;
+    if (filter == nullptr) {
+        out << "Bloom filter is disabled.\n";
+        return;
+    }
+    out << "Bloom filter: " << filter->keys << " keys, " << filter->bits.size() * 8 << " bytes, "
+        << filter->hashes << " hashes, target false positive rate " << filter->falsePositiveRate << "\n";
+    out << "Lookups: " << filter->lookups << ", rejected without descent: " << filter->rejected << "\n";
+    // Only missing words can be false positives: those rejected and those let through.
+    uint64_t missing = filter->rejected + filter->falsePositives;
+    if (missing > 0) {
+        double measured = (double) filter->falsePositives / (double) missing;
+        out << "Measured false positive rate: " << measured << " over " << missing << " missing words";
+        // With fewer misses the measurement is mostly noise.
+        if (missing >= 1000 && measured > 2 * filter->falsePositiveRate) {
+            out << ", above twice the target";
+        }
+        out << "\n";
+    }
+}
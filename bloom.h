@@ -0,0 +1,41 @@
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct Dictionary;
+
+/*
+Blocked Bloom filter over the lowercased words, consulted before the tree descent
+in searchWord(Dictionary*, ...). All bits of a key live in one 512-bit block, so a
+miss costs one hash and one cache line. The filter is rebuilt from the tree after
+bulk loads, when more keys were added than it was sized for, and once deletes since
+the last rebuild exceed a tenth of the keys (deleted keys cannot be removed from it).
+Blocks get more bits per key than a plain Bloom filter would, since the keys spread
+unevenly over them; the stats compare the rate measured on missing words to the target.
+*/
+struct BloomFilter {
+    double falsePositiveRate;
+    uint64_t capacity;
+    uint64_t keys;
+    uint64_t deletesSinceRebuild;
+    int hashes;
+    std::vector<uint64_t> bits;
+    // Since the last rebuild; a false positive is a word let through but not found.
+    uint64_t lookups;
+    uint64_t rejected;
+    uint64_t falsePositives;
+};
+
+void enableBloomFilter(Dictionary* dictionary, double falsePositiveRate);
+void disableBloomFilter(Dictionary* dictionary);
+void rebuildBloomFilter(Dictionary* dictionary);
+void bloomAdd(BloomFilter* filter, const std::string& word);
+bool bloomMayContain(BloomFilter* filter, const std::string& word);
+void bloomNoteDelete(Dictionary* dictionary);
+void printBloomStats(const Dictionary* dictionary, std::ostream& out);
+
+#endif
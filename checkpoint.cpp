@@ -0,0 +1,369 @@
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <fcntl.h>
+#include <strings.h>
+#include <unistd.h>
+
+#include "dictionary.h"
+#include "flusher.h"
+#include "lazy.h"
+#include "persistent.h"
+
+using namespace std;
+
+static string lowercase(const string& word) {
+    string lower = word;
+    for (char& c : lower) {
+        c = (char) tolower((unsigned char) c);
+    }
+    return lower;
+}
+
+// Checkpoint files live next to the manifest and are named relative to it.
+static string siblingPath(const CheckpointLog* log, const string& name) {
+    return (filesystem::path(log->manifestPath).parent_path() / name).string();
+}
+
+static string fileName(const CheckpointLog* log, const char* kind) {
+    return filesystem::path(log->manifestPath).filename().string() + "." + kind + "." + to_string(log->sequence);
+}
+
+static string journalPath(const CheckpointLog* log) {
+    return log->manifestPath + ".journal";
+}
+
+static string entryRecord(LazyStore* lazy, Node* node) {
+    materializeEntry(lazy, node);
+    string record = "+\t" + node->word + '\t' + node->meaning + '\t' + node->grammaticalCategory;
+    for (const string& synonym : node->synonyms) {
+        record += '\t' + synonym;
+    }
+    return record + '\n';
+}
+
+// Forces a written file, or a directory's entries, to disk.
+static bool syncPath(const string& path, bool directory) {
+    int fd = open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = fsync(fd) == 0;
+    close(fd);
+    return synced;
+}
+
+static bool syncDirectory(const CheckpointLog* log) {
+    string directory = filesystem::path(log->manifestPath).parent_path().string();
+    return syncPath(directory.empty() ? "." : directory, true);
+}
+
+// Writes and syncs a file next to the manifest; false on I/O errors.
+template <typename Write>
+static bool writeSibling(const CheckpointLog* log, const string& name, Write write) {
+    string path = siblingPath(log, name);
+    {
+        ofstream out(path);
+        write(out);
+        out.flush();
+        if (!out) {
+            return false;
+        }
+    }
+    return syncPath(path, false);
+}
+
+// The files named must already be on disk. The manifest only reaches disk through a
+// synced rename, so after a crash it names either the old or the new files, all of them
+// complete.
+static bool commitManifest(const CheckpointLog* log, const string& base, uint64_t baseRecords,
+                           const vector<pair<string, uint64_t>>& deltas) {
+    string temporary = log->manifestPath + ".tmp";
+    {
+        ofstream out(temporary);
+        out << "DICTMANIFEST 1\n";
+        out << "base " << base << " " << baseRecords << "\n";
+        for (const auto& [delta, records] : deltas) {
+            out << "delta " << delta << " " << records << "\n";
+        }
+        out.flush();
+        if (!out) {
+            return false;
+        }
+    }
+    if (!syncPath(temporary, false)) {
+        return false;
+    }
+    error_code error;
+    filesystem::rename(temporary, log->manifestPath, error);
+    return !error && syncDirectory(log);
+}
+
+// Keeps the last record of every word, keyed by the lowercased word, so that the
+// deltas and the journal are applied in one merge. False on a malformed record.
+static bool collectRecords(istream& in, unordered_map<string, string>& records) {
+    string line;
+    while (getline(in, line)) {
+        vector<string> fields = splitFields(line, '\t');
+        if (fields.size() < 2 || (fields[0] != "+" && fields[0] != "-")) {
+            return false;
+        }
+        records[lowercase(fields[1])] = line;
+    }
+    return true;
+}
+
+// Merges the records into a tree without accelerators in O(n + m log m): the tree
+// is flattened in order, merged with the sorted records and rebuilt balanced.
+static Node* applyRecords(Node* root, const unordered_map<string, string>& records) {
+    vector<vector<string>> sorted;
+    sorted.reserve(records.size());
+    for (const auto& record : records) {
+        sorted.push_back(splitFields(record.second, '\t'));
+        sorted.back().resize(7);
+    }
+    sort(sorted.begin(), sorted.end(), [](const vector<string>& a, const vector<string>& b) {
+        return strcasecmp(a[1].c_str(), b[1].c_str()) < 0;
+    });
+    vector<Node*> existing;
+    flattenTree(root, existing);
+    vector<Node*> merged;
+    merged.reserve(existing.size() + sorted.size());
+    size_t i = 0, j = 0;
+    while (i < existing.size() || j < sorted.size()) {
+        int order = i == existing.size() ? 1
+                  : j == sorted.size() ? -1
+                  : strcasecmp(existing[i]->word.c_str(), sorted[j][1].c_str());
+        if (order < 0) {
+            merged.push_back(existing[i++]);
+            continue;
+        }
+        if (order == 0) {
+            delete existing[i++];
+        }
+        vector<string>& fields = sorted[j++];
+        if (fields[0] == "+") {
+            merged.push_back(createNode(move(fields[1]), move(fields[2]), move(fields[3]), &fields[4]));
+        }
+    }
+    return buildBalanced(merged, 0, (int) merged.size() - 1);
+}
+
+// The last checkpoint, committed to disk, holds every change journaled so far.
+static void truncateJournal(CheckpointLog* log) {
+    if (log->flusher != nullptr) {
+        enqueueTruncate(log->flusher);
+    } else {
+        error_code error;
+        filesystem::remove(journalPath(log), error);
+    }
+}
+
+static bool writeBase(Dictionary* dictionary, CheckpointLog* log) {
+    vector<string> obsolete;
+    for (const auto& delta : log->deltas) {
+        obsolete.push_back(delta.first);
+    }
+    if (!log->base.empty()) {
+        obsolete.push_back(log->base);
+    }
+    log->sequence++;
+    string base = fileName(log, "base");
+    uint64_t baseRecords;
+    bool written;
+    if (dictionary->versions != nullptr) {
+        Snapshot snapshot = takeSnapshot(dictionary);
+        baseRecords = (uint64_t) countWords(snapshot);
+        written = writeSibling(log, base, [&snapshot](ostream& out) { saveSnapshot(snapshot, out); });
+    } else {
+        baseRecords = (uint64_t) countWords(dictionary->root);
+        written = writeSibling(log, base, [dictionary](ostream& out) { saveDictionary(dictionary->root, out, dictionary->lazy); });
+    }
+    if (!written) {
+        return false;
+    }
+    // The log keeps describing the old files until the manifest names the new one.
+    if (!commitManifest(log, base, baseRecords, {})) {
+        error_code error;
+        filesystem::remove(siblingPath(log, base), error);
+        return false;
+    }
+    log->base = base;
+    log->baseRecords = baseRecords;
+    log->deltas.clear();
+    log->deltaRecords = 0;
+    log->dirty.clear();
+    truncateJournal(log);
+    for (const string& name : obsolete) {
+        error_code error;
+        filesystem::remove(siblingPath(log, name), error);
+    }
+    return true;
+}
+
+int openCheckpoint(Dictionary* dictionary, const string& manifestPath) {
+    closeCheckpoint(dictionary);
+    CheckpointLog* log = new CheckpointLog{manifestPath, "", {}, 0, 0, 0, {}, nullptr};
+    ifstream manifest(manifestPath);
+    if (!manifest) {
+        dictionary->checkpoint = log;
+        if (!writeBase(dictionary, log)) {
+            closeCheckpoint(dictionary);
+            return -1;
+        }
+        return (int) log->baseRecords;
+    }
+
+    string header, kind, name;
+    uint64_t records;
+    getline(manifest, header);
+    if (header != "DICTMANIFEST 1" || !(manifest >> kind >> log->base >> log->baseRecords) || kind != "base") {
+        delete log;
+        return -1;
+    }
+    // Everything is read into a tree of its own first, so that a bad file leaves the
+    // dictionary as it was.
+    Dictionary loaded;
+    auto fail = [&loaded, log]() {
+        destroyTree(loaded.root, nullptr);
+        delete log;
+        return -1;
+    };
+    ifstream base(siblingPath(log, log->base));
+    if (!base || loadDictionary(&loaded, base) < 0) {
+        return fail();
+    }
+    unordered_map<string, string> changes;
+    while (manifest >> kind >> name >> records) {
+        ifstream delta(siblingPath(log, name));
+        if (kind != "delta" || !delta || !collectRecords(delta, changes)) {
+            return fail();
+        }
+        log->deltas.push_back({name, records});
+        log->deltaRecords += records;
+    }
+    // New files must not reuse the numbers of the ones listed; the last one is the highest.
+    const string& last = log->deltas.empty() ? log->base : log->deltas.back().first;
+    string number = last.substr(last.rfind('.') + 1);
+    if (number.empty() || number.size() > 18 || number.find_first_not_of("0123456789") != string::npos) {
+        return fail();
+    }
+    log->sequence = stoull(number);
+    // The journal's records come after the deltas'. A torn record at the end is
+    // dropped, and the words replayed stay dirty so the next checkpoint keeps them.
+    ifstream journal(journalPath(log));
+    if (journal) {
+        string text((istreambuf_iterator<char>(journal)), istreambuf_iterator<char>());
+        text.resize(text.rfind('\n') == string::npos ? 0 : text.rfind('\n') + 1);
+        stringstream lines(text);
+        unordered_map<string, string> replayed;
+        if (!collectRecords(lines, replayed)) {
+            return fail();
+        }
+        for (auto& [word, line] : replayed) {
+            log->dirty.insert(word);
+            changes[word] = move(line);
+        }
+    }
+    replaceTree(dictionary, applyRecords(loaded.root, changes));
+    dictionary->checkpoint = log;
+    return countWords(dictionary->root);
+}
+
+void closeCheckpoint(Dictionary* dictionary) {
+    stopJournal(dictionary);
+    delete dictionary->checkpoint;
+    dictionary->checkpoint = nullptr;
+}
+
+void markDirty(Dictionary* dictionary, const string& word, Node* entry) {
+    CheckpointLog* log = dictionary->checkpoint;
+    if (log == nullptr) {
+        return;
+    }
+    log->dirty.insert(lowercase(word));
+    if (log->flusher != nullptr) {
+        enqueueRecord(log->flusher, entry != nullptr ? entryRecord(dictionary->lazy, entry) : "-\t" + word + '\n');
+    }
+}
+
+bool startJournal(Dictionary* dictionary, unsigned intervalMs, size_t batchSize) {
+    CheckpointLog* log = dictionary->checkpoint;
+    if (log == nullptr) {
+        return false;
+    }
+    stopJournal(dictionary);
+    log->flusher = startFlusher(journalPath(log), chrono::milliseconds(intervalMs), batchSize);
+    return log->flusher != nullptr;
+}
+
+void stopJournal(Dictionary* dictionary) {
+    if (dictionary->checkpoint != nullptr) {
+        stopFlusher(dictionary->checkpoint->flusher);
+        dictionary->checkpoint->flusher = nullptr;
+    }
+}
+
+bool syncJournal(Dictionary* dictionary) {
+    JournalFlusher* flusher = dictionary->checkpoint != nullptr ? dictionary->checkpoint->flusher : nullptr;
+    return flusher != nullptr && waitDurable(flusher, flusher->enqueued);
+}
+
+bool writeCheckpoint(Dictionary* dictionary, bool full) {
+    CheckpointLog* log = dictionary->checkpoint;
+    if (log == nullptr) {
+        return false;
+    }
+    // Replaying the journal must not take the checkpoint back to an older state, so
+    // the journal has to hold every change the checkpoint holds.
+    if (log->flusher != nullptr && !syncJournal(dictionary)) {
+        return false;
+    }
+    if (full || (log->deltaRecords + log->dirty.size()) * 2 > log->baseRecords) {
+        return writeBase(dictionary, log);
+    }
+    if (log->dirty.empty()) {
+        return true;
+    }
+
+    log->sequence++;
+    string delta = fileName(log, "delta");
+    bool written = writeSibling(log, delta, [dictionary, log](ostream& out) {
+        for (const string& word : log->dirty) {
+            Node* node = findNode(dictionary->root, word);
+            out << (node != nullptr ? entryRecord(dictionary->lazy, node) : "-\t" + word + '\n');
+        }
+    });
+    if (!written) {
+        return false;
+    }
+    log->deltas.push_back({delta, log->dirty.size()});
+    if (!commitManifest(log, log->base, log->baseRecords, log->deltas)) {
+        log->deltas.pop_back();
+        error_code error;
+        filesystem::remove(siblingPath(log, delta), error);
+        return false;
+    }
+    log->deltaRecords += log->dirty.size();
+    log->dirty.clear();
+    truncateJournal(log);
+    return true;
+}
+
+void printCheckpointStats(const Dictionary* dictionary, ostream& out) {
+    const CheckpointLog* log = dictionary->checkpoint;
+    if (log == nullptr) {
+        out << "Checkpointing is disabled.\n";
+        return;
+    }
+    out << "Checkpoint " << log->manifestPath << ": base " << log->base << " (" << log->baseRecords
+        << " words), " << log->deltas.size() << " deltas, " << log->dirty.size() << " dirty words\n";
+    if (log->flusher != nullptr) {
+        printFlusherStats(log->flusher, out);
+    }
+}
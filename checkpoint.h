@@ -0,0 +1,70 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+struct Dictionary;
+struct JournalFlusher;
+struct Node;
+
+/*
+Incremental checkpoints. While checkpointing is on, every add, modify and delete
+marks its word dirty. A checkpoint writes one delta file holding only the dirty
+words: the current entry of each word still present, and a delete record for each
+word that is gone. It then commits a new manifest naming the base snapshot and
+the deltas to apply on top of it, in order. Files are fsynced before the manifest
+names them and the manifest is replaced with a rename followed by a sync of the
+directory, so a crash or power loss leaves either the old or the new checkpoint.
+The cost of a checkpoint grows with the number of changed words, not with the
+dictionary.
+
+Once the deltas add up to more than half the records of the base, the next
+checkpoint writes a new full base instead and drops the old files.
+
+Changes made between checkpoints can also be journaled as they happen. The journal
+holds the same records as a delta, one per change, and is written by a background
+flusher (see flusher.h), so a change costs only an enqueue. Opening the checkpoint
+replays the journal after the deltas; every checkpoint empties it.
+
+Files, next to the manifest path M:
+    M               DICTMANIFEST 1, then "base <file> <words>" and "delta <file> <records>" lines
+    M.base.N        a dictionary file
+    M.delta.N       lines "+ <entry fields>" or "- <word>", tab separated
+    M.journal       delta records in the order the changes were made
+*/
+struct CheckpointLog {
+    std::string manifestPath;
+    std::string base;
+    std::vector<std::pair<std::string, uint64_t>> deltas;
+    uint64_t baseRecords;
+    uint64_t deltaRecords;
+    uint64_t sequence;
+    // Lowercased, as words are matched ignoring case.
+    std::unordered_set<std::string> dirty;
+    JournalFlusher* flusher;
+};
+
+// Replaces the dictionary's words with the checkpoint at manifestPath when it exists,
+// or else writes the current dictionary as its first base. Returns the number of
+// words loaded, or -1 when an existing checkpoint cannot be read, which leaves the
+// words unchanged.
+int openCheckpoint(Dictionary* dictionary, const std::string& manifestPath);
+void closeCheckpoint(Dictionary* dictionary);
+// Call after the change; entry is the word's node, or nullptr once it is deleted.
+void markDirty(Dictionary* dictionary, const std::string& word, Node* entry);
+// Writes a delta (or a new base when due, or when full is set); false on I/O errors.
+bool writeCheckpoint(Dictionary* dictionary, bool full = false);
+// Journals every later change through a flusher that writes at least every
+// intervalMs milliseconds (0 for no timer) or batchSize records. False without a
+// checkpoint.
+bool startJournal(Dictionary* dictionary, unsigned intervalMs, size_t batchSize);
+void stopJournal(Dictionary* dictionary);
+// Waits until every change made so far is in the journal; false on I/O errors.
+bool syncJournal(Dictionary* dictionary);
+void printCheckpointStats(const Dictionary* dictionary, std::ostream& out);
+
+#endif
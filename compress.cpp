@@ -0,0 +1,121 @@
+#include "compress.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+using namespace std;
+
+static const int trainingRounds = 5;
+
+static uint64_t packSymbol(const char* bytes, size_t length) {
+    uint64_t symbol = 0;
+    memcpy(&symbol, bytes, length);
+    return symbol;
+}
+
+void SymbolTable::rebuildIndex() {
+    for (auto& codes : byFirstByte) {
+        codes.clear();
+    }
+    for (int code = 0; code < count; code++) {
+        byFirstByte[(uint8_t) symbols[code]].push_back((uint8_t) code);
+    }
+    for (auto& codes : byFirstByte) {
+        stable_sort(codes.begin(), codes.end(), [this](uint8_t a, uint8_t b) { return lengths[a] > lengths[b]; });
+    }
+}
+
+// Longest symbol matching text at position, or -1 when the byte has to be escaped.
+static int matchSymbol(const SymbolTable& table, string_view text, size_t position) {
+    size_t remaining = text.size() - position;
+    for (uint8_t code : table.byFirstByte[(uint8_t) text[position]]) {
+        size_t length = table.lengths[code];
+        if (length <= remaining && packSymbol(text.data() + position, length) == table.symbols[code]) {
+            return code;
+        }
+    }
+    return -1;
+}
+
+/*
+Each round encodes the sample with the current table and counts every emitted
+symbol (escaped bytes count as one-byte symbols) and every concatenation of two
+consecutive symbols that fits in 8 bytes. The 255 candidates that would save the
+most bytes (frequency times length) become the next table.
+*/
+SymbolTable trainSymbolTable(const vector<string_view>& sample) {
+    SymbolTable table;
+    for (int round = 0; round < trainingRounds; round++) {
+        unordered_map<string, uint64_t> gains;
+        for (string_view text : sample) {
+            string previous;
+            size_t position = 0;
+            while (position < text.size()) {
+                int code = matchSymbol(table, text, position);
+                size_t length = code < 0 ? 1 : table.lengths[code];
+                string current(text.substr(position, length));
+                gains[current] += length;
+                if (!previous.empty() && previous.size() + current.size() <= 8) {
+                    gains[previous + current] += previous.size() + current.size();
+                }
+                previous = move(current);
+                position += length;
+            }
+        }
+
+        vector<pair<uint64_t, string>> candidates;
+        candidates.reserve(gains.size());
+        for (auto& [symbol, gain] : gains) {
+            candidates.push_back({gain, symbol});
+        }
+        size_t keep = min<size_t>(candidates.size(), 255);
+        partial_sort(candidates.begin(), candidates.begin() + keep, candidates.end(),
+                     [](const auto& a, const auto& b) { return a.first != b.first ? a.first > b.first : a.second < b.second; });
+
+        table.count = (int) keep;
+        for (size_t code = 0; code < keep; code++) {
+            const string& symbol = candidates[code].second;
+            table.symbols[code] = packSymbol(symbol.data(), symbol.size());
+            table.lengths[code] = (uint8_t) symbol.size();
+        }
+        table.rebuildIndex();
+    }
+    return table;
+}
+
+void compressText(const SymbolTable& table, string_view text, string& out) {
+    size_t position = 0;
+    while (position < text.size()) {
+        int code = matchSymbol(table, text, position);
+        if (code < 0) {
+            out.push_back((char) SymbolTable::escape);
+            out.push_back(text[position]);
+            position++;
+        } else {
+            out.push_back((char) code);
+            position += table.lengths[code];
+        }
+    }
+}
+
+// Writes whole 8-byte symbols and advances by their real length, so the output
+// buffer gets 8 bytes of slack that are trimmed at the end.
+void decompressText(const SymbolTable& table, const char* data, size_t size, size_t originalSize, string& out) {
+    out.resize(originalSize + 8);
+    char* target = out.data();
+    const uint8_t* code = (const uint8_t*) data;
+    const uint8_t* end = code + size;
+    const char* limit = out.data() + originalSize;
+    while (code < end && target <= limit) {
+        if (*code == SymbolTable::escape) {
+            *target++ = (char) code[1];
+            code += 2;
+        } else {
+            memcpy(target, &table.symbols[*code], 8);
+            target += table.lengths[*code];
+            code++;
+        }
+    }
+    out.resize(originalSize);
+}
@@ -0,0 +1,34 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Static symbol-table text compression in the style of FSST. Up to 255 symbols of
+1 to 8 bytes are trained on a sample of the corpus; each symbol is encoded as a
+single code byte and bytes not covered by a symbol are written as the escape code
+followed by the literal byte. Every string is compressed on its own, so any entry
+can be decompressed without touching its neighbours, and decoding is one table
+lookup and one 8-byte copy per code.
+*/
+
+struct SymbolTable {
+    static const uint8_t escape = 255;
+
+    int count = 0;
+    uint64_t symbols[255] = {};
+    uint8_t lengths[255] = {};
+    // Codes grouped by first byte, longest symbol first, for greedy encoding.
+    std::vector<uint8_t> byFirstByte[256];
+
+    void rebuildIndex();
+};
+
+SymbolTable trainSymbolTable(const std::vector<std::string_view>& sample);
+void compressText(const SymbolTable& table, std::string_view text, std::string& out);
+void decompressText(const SymbolTable& table, const char* data, size_t size, size_t originalSize, std::string& out);
+
+#endif
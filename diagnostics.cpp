@@ -0,0 +1,126 @@
+#include "diagnostics.h"
+
+using namespace std;
+
+// Rebuilding is flagged once the average search is this much longer than in a
+// perfectly balanced tree of the same size.
+static const double rebuildDepthRatio = 1.5;
+static const long rebuildMinimumCount = 64;
+
+static double optimalAverageDepth(long count) {
+    if (count == 0) {
+        return 0;
+    }
+    double total = 0;
+    long remaining = count;
+    long levelCapacity = 1;
+    for (int depth = 1; remaining > 0; depth++) {
+        long onLevel = remaining < levelCapacity ? remaining : levelCapacity;
+        total += (double) onLevel * depth;
+        remaining -= onLevel;
+        levelCapacity *= 2;
+    }
+    return total / count;
+}
+
+/*
+Walks the tree once in post-order with an explicit stack, so degenerate trees
+cannot overflow the call stack. Subtree sizes are returned through a second
+stack to compute the size-weighted imbalance: the sum of |left size - right size|
+over all nodes divided by the sum of (left size + right size), which is 0 for a
+perfectly balanced tree and 1 for a linked list.
+*/
+TreeShape analyzeTree(Node* root) {
+    TreeShape shape = {};
+    struct Frame {
+        Node* node;
+        int depth;
+        int leftRun;
+        int rightRun;
+        bool expanded;
+    };
+    vector<Frame> stack;
+    vector<long> sizes;
+    long totalDepth = 0;
+    long skew = 0;
+    long weight = 0;
+    if (root != nullptr) {
+        stack.push_back({root, 1, 1, 1, false});
+    }
+    while (!stack.empty()) {
+        Frame& frame = stack.back();
+        Node* node = frame.node;
+        if (!frame.expanded) {
+            frame.expanded = true;
+            int depth = frame.depth;
+            int leftRun = frame.leftRun;
+            int rightRun = frame.rightRun;
+            shape.count++;
+            totalDepth += depth;
+            if (depth > shape.height) {
+                shape.height = depth;
+            }
+            if ((int) shape.levelCounts.size() < depth) {
+                shape.levelCounts.resize(depth, 0);
+            }
+            shape.levelCounts[depth - 1]++;
+            if (leftRun > shape.longestLeftChain) {
+                shape.longestLeftChain = leftRun;
+            }
+            if (rightRun > shape.longestRightChain) {
+                shape.longestRightChain = rightRun;
+            }
+            // Right is pushed first so the left subtree finishes first and its size sits below.
+            if (node->right != nullptr) {
+                stack.push_back({node->right, depth + 1, 1, rightRun + 1, false});
+            }
+            if (node->left != nullptr) {
+                stack.push_back({node->left, depth + 1, leftRun + 1, 1, false});
+            }
+            continue;
+        }
+        long rightSize = 0;
+        long leftSize = 0;
+        if (node->right != nullptr) {
+            rightSize = sizes.back();
+            sizes.pop_back();
+        }
+        if (node->left != nullptr) {
+            leftSize = sizes.back();
+            sizes.pop_back();
+        }
+        skew += leftSize > rightSize ? leftSize - rightSize : rightSize - leftSize;
+        weight += leftSize + rightSize;
+        sizes.push_back(leftSize + rightSize + 1);
+        stack.pop_back();
+    }
+
+    shape.averageDepth = shape.count > 0 ? (double) totalDepth / shape.count : 0;
+    shape.optimalAverageDepth = optimalAverageDepth(shape.count);
+    shape.imbalance = weight > 0 ? (double) skew / weight : 0;
+    shape.rebuildRecommended = shape.count >= rebuildMinimumCount
+                               && shape.averageDepth > rebuildDepthRatio * shape.optimalAverageDepth;
+    return shape;
+}
+
+void printTreeShape(const TreeShape& shape, ostream& out) {
+    out << "Words: " << shape.count << "\n";
+    out << "Height: " << shape.height << "\n";
+    out << "Average search depth: " << shape.averageDepth
+        << " (balanced: " << shape.optimalAverageDepth << ")\n";
+    out << "Maximum search depth: " << shape.height << "\n";
+    out << "Imbalance: " << shape.imbalance << "\n";
+    out << "Longest left chain: " << shape.longestLeftChain << "\n";
+    out << "Longest right chain: " << shape.longestRightChain << "\n";
+    out << "Nodes per level:";
+    for (long levelCount : shape.levelCounts) {
+        out << " " << levelCount;
+    }
+    out << "\n";
+    if (shape.rebuildRecommended) {
+        out << "Rebuild recommended: average depth is "
+            << shape.averageDepth / shape.optimalAverageDepth << "x the balanced depth.\n";
+    } else {
+        out << "Rebuild not needed.\n";
+    }
+}
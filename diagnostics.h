@@ -0,0 +1,25 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <ostream>
+#include <vector>
+
+#include "dictionary.h"
+
+// Depths count nodes on the search path, so the root has depth 1.
+struct TreeShape {
+    long count;
+    int height;
+    double averageDepth;
+    double optimalAverageDepth;
+    std::vector<long> levelCounts;
+    double imbalance;
+    int longestLeftChain;
+    int longestRightChain;
+    bool rebuildRecommended;
+};
+
+TreeShape analyzeTree(Node* root);
+void printTreeShape(const TreeShape& shape, std::ostream& out);
+
+#endif
@@ -0,0 +1,140 @@
+/*
+Diff and merge tool for two dictionary files (text or frozen).
+
+Both files are loaded into trees and walked in order at the same time, so every
+word is compared once and the output comes out alphabetically. Each difference is
+written as one tab separated line, prefixed with:
+    +   the entry is only in the second file
+    -   the entry is only in the first file
+    ~   the entry is in both but differs; the second file's version is shown
+Words match ignoring case, like in the dictionary; a change of case is a change.
+
+With --merged, the union of both files is written in the dictionary file format.
+Entries present in both files but different are resolved by --policy:
+    ours        keep the first file's entry (default)
+    theirs      take the second file's entry
+    drop        leave the word out of the merged file
+
+A summary of the counts goes to stderr. The exit status is 0 when the files hold
+the same entries, 1 when they differ and 2 on errors.
+
+Usage: dictdiff first.tsv second.tsv [--diff diff.tsv|-] [--merged merged.tsv]
+                [--policy ours|theirs|drop]
+*/
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <strings.h>
+
+#include "batch.h"
+#include "dictionary.h"
+#include "iterator.h"
+
+using namespace std;
+
+enum ConflictPolicy {
+    KEEP_OURS,
+    TAKE_THEIRS,
+    DROP_CONFLICTS
+};
+
+static bool sameEntry(const Node& a, const Node& b) {
+    return a.word == b.word && a.meaning == b.meaning && a.grammaticalCategory == b.grammaticalCategory
+           && a.synonyms[0] == b.synonyms[0] && a.synonyms[1] == b.synonyms[1] && a.synonyms[2] == b.synonyms[2];
+}
+
+static void writeChange(ostream& out, char change, const Node& node) {
+    out << change << '\t';
+    writeEntry(out, node);
+}
+
+int main(int argc, char** argv) {
+    // Options come in flag and value pairs, so a flag left without its value is an error too.
+    if (argc < 3 || (argc - 3) % 2 != 0) {
+        cerr << "Usage: dictdiff first.tsv second.tsv [--diff diff.tsv|-] [--merged merged.tsv]"
+                " [--policy ours|theirs|drop]\n";
+        return 2;
+    }
+    string diffPath = "-", mergedPath;
+    ConflictPolicy policy = KEEP_OURS;
+    for (int i = 3; i < argc; i += 2) {
+        string flag = argv[i];
+        string value = argv[i + 1];
+        if (flag == "--diff") {
+            diffPath = value;
+        } else if (flag == "--merged") {
+            mergedPath = value;
+        } else if (flag == "--policy" && (value == "ours" || value == "theirs" || value == "drop")) {
+            policy = value == "ours" ? KEEP_OURS : (value == "theirs" ? TAKE_THEIRS : DROP_CONFLICTS);
+        } else {
+            cerr << "Unknown option: " << flag << " " << value << "\n";
+            return 2;
+        }
+    }
+
+    Dictionary first, second;
+    for (auto [dictionary, path] : {pair{&first, argv[1]}, pair{&second, argv[2]}}) {
+        if (loadDictionaryFile(dictionary, path) < 0) {
+            cerr << "Cannot load " << path << "\n";
+            return 2;
+        }
+    }
+
+    ofstream diffFile, mergedFile;
+    if (diffPath != "-") {
+        diffFile.open(diffPath);
+    }
+    ostream& diff = diffPath == "-" ? cout : diffFile;
+    if (!mergedPath.empty()) {
+        mergedFile.open(mergedPath);
+    }
+    if (!diff || (!mergedPath.empty() && !mergedFile)) {
+        cerr << "Cannot open the output files\n";
+        return 2;
+    }
+    bool merging = mergedFile.is_open();
+
+    size_t added = 0, removed = 0, changed = 0, unchanged = 0;
+    DictionaryView ours = dictionaryView(&first), theirs = dictionaryView(&second);
+    DictionaryIterator a = ours.begin(), b = theirs.begin();
+    while (a != ours.end() || b != theirs.end()) {
+        int order = a == ours.end() ? 1 : (b == theirs.end() ? -1 : strcasecmp(a->word.c_str(), b->word.c_str()));
+        if (order < 0) {
+            writeChange(diff, '-', *a);
+            if (merging) {
+                writeEntry(mergedFile, *a);
+            }
+            removed++;
+            ++a;
+        } else if (order > 0) {
+            writeChange(diff, '+', *b);
+            if (merging) {
+                writeEntry(mergedFile, *b);
+            }
+            added++;
+            ++b;
+        } else {
+            if (sameEntry(*a, *b)) {
+                unchanged++;
+                if (merging) {
+                    writeEntry(mergedFile, *a);
+                }
+            } else {
+                writeChange(diff, '~', *b);
+                changed++;
+                if (merging && policy != DROP_CONFLICTS) {
+                    writeEntry(mergedFile, policy == KEEP_OURS ? *a : *b);
+                }
+            }
+            ++a;
+            ++b;
+        }
+    }
+
+    cerr << "added " << added << ", removed " << removed << ", changed " << changed
+         << ", unchanged " << unchanged << "\n";
+    destroyTree(first.root, nullptr);
+    destroyTree(second.root, nullptr);
+    return added + removed + changed == 0 ? 0 : 1;
+}
@@ -0,0 +1,613 @@
+#include "dictionary.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <strings.h>
+
+#include "bloom.h"
+#include "checkpoint.h"
+#include "hashindex.h"
+#include "hotcache.h"
+#include "iterator.h"
+#include "lazy.h"
+#include "persistent.h"
+#include "scapegoat.h"
+#include "stats.h"
+#include "tombstone.h"
+
+using namespace std;
+
+// Moves the arguments, and the contents of synonyms, into the new node.
+Node* createNode(string word, string meaning, string grammaticalCategory, string synonyms[3]) {
+    Node* newNode = new Node();
+    newNode->word = move(word);
+    newNode->meaning = move(meaning);
+    newNode->grammaticalCategory = move(grammaticalCategory);
+    for (int i = 0; i < 3; i++) {
+        newNode->synonyms[i] = move(synonyms[i]);
+    }
+    newNode->offset = -1;
+    newNode->tombstone = false;
+    newNode->left = nullptr;
+    newNode->right = nullptr;
+    return newNode;
+}
+
+void insertNode(Node* root, Node* newNode) {
+    STAT_SCOPE(STAT_INSERT, root);
+    STAT_COMPARE();
+    if (strcasecmp(newNode->word.c_str(), root->word.c_str()) < 0) {
+        if (root->left == nullptr) {
+            root->left = newNode;
+        } else {
+            insertNode(root->left, newNode);
+        }
+    } else {
+        STAT_COMPARE();
+        if(strcasecmp(newNode->word.c_str(), root->word.c_str()) == 0) {
+            cout << "Word already exists in the dictionary.\n";
+            return;
+        }
+        if (root->right == nullptr) {
+            root->right = newNode;
+        } else {
+            insertNode(root->right, newNode);
+        }
+    }
+}
+
+/*
+Inserts a word unless it already exists. The duplicate check happens during the
+descent, before anything is allocated; the arguments and the contents of synonyms
+are then moved into the new node, so callers passing rvalues copy no strings.
+Returns the inserted or the existing node, and whether it was inserted.
+*/
+pair<Node*, bool> emplaceWord(Dictionary* dictionary, string word, string meaning, string grammaticalCategory, string synonyms[3]) {
+    STAT_SCOPE(STAT_INSERT, nullptr);
+    Node** link = &dictionary->root;
+    vector<Node**> ancestors;
+    int depth = 0;
+    while (*link != nullptr) {
+        STAT_VISIT(++depth);
+        STAT_COMPARE();
+        int order = strcasecmp(word.c_str(), (*link)->word.c_str());
+        if (order == 0) {
+            if (!(*link)->tombstone) {
+                return {*link, false};
+            }
+            break;
+        }
+        if (dictionary->alpha > 0) {
+            ancestors.push_back(link);
+        }
+        link = order < 0 ? &(*link)->left : &(*link)->right;
+    }
+    Node* newNode = *link;
+    if (newNode != nullptr) {
+        // The word's tombstone takes the new entry in place.
+        forgetEntry(dictionary->lazy, newNode);
+        newNode->word = move(word);
+        newNode->meaning = move(meaning);
+        newNode->grammaticalCategory = move(grammaticalCategory);
+        for (int i = 0; i < 3; i++) {
+            newNode->synonyms[i] = move(synonyms[i]);
+        }
+        newNode->offset = -1;
+        newNode->tombstone = false;
+        dictionary->tombstones--;
+    } else {
+        newNode = createNode(move(word), move(meaning), move(grammaticalCategory), synonyms);
+        *link = newNode;
+        if (dictionary->alpha > 0) {
+            scapegoatAfterInsert(dictionary, ancestors, newNode);
+        } else if (dictionary->tombstoneRatio > 0) {
+            dictionary->size++;
+        }
+    }
+    noteChange(dictionary, newNode->word, newNode);
+    if (dictionary->index != nullptr) {
+        hashIndexInsert(dictionary->index, newNode);
+    }
+    if (dictionary->filter != nullptr) {
+        bloomAdd(dictionary->filter, newNode->word);
+        if (dictionary->filter->keys > dictionary->filter->capacity) {
+            rebuildBloomFilter(dictionary);
+        }
+    }
+    return {newNode, true};
+}
+
+// Copies the caller's synonyms, which stay untouched; returns false for a duplicate.
+bool addWord(Dictionary* dictionary, string word, string meaning, string grammaticalCategory, string synonyms[3]) {
+    string ownSynonyms[3] = {synonyms[0], synonyms[1], synonyms[2]};
+    bool inserted = emplaceWord(dictionary, move(word), move(meaning), move(grammaticalCategory), ownSynonyms).second;
+    if (!inserted) {
+        cout << "Word already exists in the dictionary.\n";
+    }
+    return inserted;
+}
+
+void showWord(Node* word, LazyStore* lazy) {
+    materializeEntry(lazy, word);
+    cout << "Word: " << word->word << "\n";
+    cout << "Meaning: " << word->meaning << "\n";
+    cout << "Grammatical Category: " << word->grammaticalCategory << "\n";
+    cout << "Synonyms: ";
+    for (int i = 0; i < 3; i++) {
+        cout << word->synonyms[i] << " ";
+    }
+    cout << "\n";
+}
+
+void showWord(const WordEntry& entry) {
+    cout << "Word: " << entry.word << "\n";
+    cout << "Meaning: " << entry.meaning << "\n";
+    cout << "Grammatical Category: " << entry.grammaticalCategory << "\n";
+    cout << "Synonyms: ";
+    for (const string& synonym : entry.synonyms) {
+        cout << synonym << " ";
+    }
+    cout << "\n";
+}
+
+void deleteWord(Node*& root, string word, LazyStore* lazy) {
+    STAT_SCOPE(STAT_DELETE, root);
+    if (root == nullptr) {
+        cout << "Word not found.\n";
+        return;
+    }
+    STAT_COMPARE();
+    int order = strcasecmp(word.c_str(), root->word.c_str());
+    if (order == 0) {
+        if (root->left == nullptr) {
+            Node* temp = root->right;
+            forgetEntry(lazy, root);
+            delete root;
+            root = temp;
+        } else if (root->right == nullptr) {
+            Node* temp = root->left;
+            forgetEntry(lazy, root);
+            delete root;
+            root = temp;
+        } else {
+            Node* temp = root->right;
+            while (temp->left != nullptr) {
+                temp = temp->left;
+            }
+            forgetEntry(lazy, root);
+            root->word = temp->word;
+            root->offset = temp->offset;
+            root->meaning = temp->meaning;
+            root->grammaticalCategory = temp->grammaticalCategory;
+            for (int i = 0; i < 3; i++) {
+                root->synonyms[i] = temp->synonyms[i];
+            }
+            deleteWord(root->right, temp->word, lazy);
+        }
+    } else if (order < 0) {
+        deleteWord(root->left, word, lazy);
+    } else {
+        deleteWord(root->right, word, lazy);
+    }
+}
+
+// In tombstone mode the node is only marked, which costs one lookup.
+static void tombstoneWord(Dictionary* dictionary, const string& word) {
+    Node* target = findNode(dictionary->root, word);
+    if (target == nullptr) {
+        cout << "Word not found.\n";
+        return;
+    }
+    if (dictionary->hotCache != nullptr) {
+        hotCacheForget(dictionary->hotCache, target->word);
+    }
+    if (dictionary->index != nullptr) {
+        hashIndexErase(dictionary->index, target->word);
+    }
+    target->tombstone = true;
+    bloomNoteDelete(dictionary);
+    noteChange(dictionary, word, nullptr);
+    tombstoneAfterDelete(dictionary);
+}
+
+// The lookups of the target are part of the delete and counted under it, not as searches.
+void deleteWord(Dictionary* dictionary, string word) {
+    STAT_SCOPE(STAT_DELETE, nullptr);
+    if (dictionary->tombstoneRatio > 0) {
+        tombstoneWord(dictionary, word);
+        return;
+    }
+    Node* target = nullptr;
+    if (dictionary->hotCache != nullptr || dictionary->index != nullptr || dictionary->filter != nullptr
+        || dictionary->alpha > 0 || dictionary->checkpoint != nullptr || dictionary->versions != nullptr) {
+        // The node holding word is freed, or overwritten by its successor whose node is freed.
+        target = findNode(dictionary->root, word);
+        if (target != nullptr) {
+            Node* successor = nullptr;
+            if (target->left != nullptr && target->right != nullptr) {
+                successor = target->right;
+                while (successor->left != nullptr) {
+                    successor = successor->left;
+                }
+            }
+            if (dictionary->hotCache != nullptr) {
+                hotCacheForget(dictionary->hotCache, target->word);
+                if (successor != nullptr) {
+                    hotCacheForget(dictionary->hotCache, successor->word);
+                }
+            }
+            if (dictionary->index != nullptr) {
+                hashIndexErase(dictionary->index, target->word);
+                if (successor != nullptr) {
+                    hashIndexRepoint(dictionary->index, successor->word, target);
+                }
+            }
+        }
+    }
+    deleteWord(dictionary->root, word, dictionary->lazy);
+    // Without any of the features above, target stays null and there is nothing to update.
+    if (target == nullptr) {
+        return;
+    }
+    bloomNoteDelete(dictionary);
+    if (dictionary->alpha > 0) {
+        scapegoatAfterDelete(dictionary);
+    }
+    noteChange(dictionary, word, nullptr);
+}
+
+void listByCategory(Node* root, string category, LazyStore* lazy) {
+    STAT_SCOPE(STAT_LIST_CATEGORY, nullptr);
+    DictionaryView words = dictionaryView(root);
+    for (auto it = words.begin(); it != words.end(); ++it) {
+        STAT_VISIT(it.depth());
+        STAT_COMPARE();
+        if (it->grammaticalCategory == category) {
+            showWord(&*it, lazy);
+        }
+    }
+}
+
+// Words sharing a first letter (ignoring case) are contiguous in the tree, so
+// only that run is walked; the exact-case check keeps the old output.
+void listByLetter(Node* root, char letter, LazyStore* lazy) {
+    STAT_SCOPE(STAT_LIST_LETTER, nullptr);
+    DictionaryView words = dictionaryView(root);
+    int folded = tolower((unsigned char) letter);
+    for (auto it = words.lower_bound(string(1, letter)); it != words.end(); ++it) {
+        STAT_VISIT(it.depth());
+        STAT_COMPARE();
+        if (tolower((unsigned char) it->word[0]) != folded) {
+            break;
+        }
+        if (it->word[0] == letter) {
+            showWord(&*it, lazy);
+        }
+    }
+}
+
+void listAllWords (Node* root, LazyStore* lazy) {
+    STAT_SCOPE(STAT_LIST_ALL, nullptr);
+    DictionaryView words = dictionaryView(root);
+    for (auto it = words.begin(); it != words.end(); ++it) {
+        STAT_VISIT(it.depth());
+        showWord(&*it, lazy);
+    }
+}
+
+void showFirstAndLast(Node* root, LazyStore* lazy) {
+    DictionaryView words = dictionaryView(root);
+    if (words.empty()) {
+        cout << "Dictionary is empty.\n";
+        return;
+    }
+    Node& first = words.front();
+    Node& last = words.back();
+    cout << "First word: " << first.word << "\n";
+    showWord(&first, lazy);
+    cout << "Last word: " << last.word << "\n";
+    showWord(&last, lazy);
+}
+
+int countWords(Node* root) {
+    STAT_SCOPE(STAT_COUNT, root);
+    if (root == nullptr) {
+        return 0;
+    }
+    return (root->tombstone ? 0 : 1) + countWords(root->left) + countWords(root->right);
+}
+
+Node *searchWord(Node *root, const string& word) {
+    STAT_SCOPE(STAT_SEARCH, root);
+    if (root == nullptr) {
+        return root;
+    }
+    STAT_COMPARE();
+    int order = strcasecmp(word.c_str(), root->word.c_str());
+    if (order == 0) {
+        return root->tombstone ? nullptr : root;
+    }
+    if (order < 0) {
+        return searchWord(root->left, word);
+    }
+    return searchWord(root->right, word);
+}
+
+Node* findNode(Node* root, const string& word) {
+    int depth = 0;
+    while (root != nullptr) {
+        STAT_VISIT(++depth);
+        STAT_COMPARE();
+        int order = strcasecmp(word.c_str(), root->word.c_str());
+        if (order == 0) {
+            return root->tombstone ? nullptr : root;
+        }
+        root = order < 0 ? root->left : root->right;
+    }
+    return nullptr;
+}
+
+// Answers from the hash index when there is one, or else from the front cache
+// before descending the tree.
+static Node* lookupWord(Dictionary* dictionary, const string& word) {
+    if (dictionary->index != nullptr) {
+        return hashIndexFind(dictionary->index, word);
+    }
+    if (dictionary->hotCache != nullptr) {
+        Node* cached = hotCacheFind(dictionary->hotCache, word);
+        if (cached != nullptr) {
+            return cached;
+        }
+    }
+    Node* found = searchWord(dictionary->root, word);
+    if (found != nullptr && dictionary->hotCache != nullptr) {
+        hotCacheOffer(dictionary->hotCache, word, found);
+    }
+    return found;
+}
+
+// Rejects most missing words through the Bloom filter before the lookup, and counts
+// the ones it let through towards its measured false positive rate.
+Node* searchWord(Dictionary* dictionary, const string& word) {
+    if (dictionary->filter == nullptr) {
+        return lookupWord(dictionary, word);
+    }
+    if (!bloomMayContain(dictionary->filter, word)) {
+        return nullptr;
+    }
+    Node* found = lookupWord(dictionary, word);
+    if (found == nullptr) {
+        dictionary->filter->falsePositives++;
+    }
+    return found;
+}
+
+void destroyTree(Node* root, LazyStore* lazy) {
+    if (root == nullptr) {
+        return;
+    }
+    destroyTree(root->left, lazy);
+    destroyTree(root->right, lazy);
+    forgetEntry(lazy, root);
+    delete root;
+}
+
+// FNV-1a over the lowercased bytes, then a final mix so the low bits are usable.
+// Words equal under strcasecmp hash the same.
+uint64_t hashWord(const string& word) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : word) {
+        hash ^= (uint8_t) tolower((unsigned char) c);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+vector<string> splitFields(const string& line, char separator) {
+    vector<string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t end = line.find(separator, start);
+        if (end == string::npos) {
+            fields.push_back(line.substr(start));
+            return fields;
+        }
+        fields.push_back(line.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+// Links nodes[low..high], already sorted by word, into a perfectly balanced subtree.
+Node* buildBalanced(vector<Node*>& nodes, int low, int high) {
+    if (low > high) {
+        return nullptr;
+    }
+    int middle = low + (high - low) / 2;
+    Node* root = nodes[middle];
+    root->left = buildBalanced(nodes, low, middle - 1);
+    root->right = buildBalanced(nodes, middle + 1, high);
+    return root;
+}
+
+// Appends the nodes in alphabetical order; iterative so degenerate trees are safe.
+void flattenTree(Node* root, vector<Node*>& nodes) {
+    vector<Node*> stack;
+    Node* current = root;
+    while (current != nullptr || !stack.empty()) {
+        while (current != nullptr) {
+            stack.push_back(current);
+            current = current->left;
+        }
+        current = stack.back();
+        stack.pop_back();
+        nodes.push_back(current);
+        current = current->right;
+    }
+}
+
+// flattenTree without the tombstones, for structures describing only the live words.
+void flattenLiveTree(Node* root, vector<Node*>& nodes) {
+    flattenTree(root, nodes);
+    erase_if(nodes, [](Node* node) { return node->tombstone; });
+}
+
+void rebuildTree(Dictionary* dictionary) {
+    vector<Node*> nodes;
+    flattenTree(dictionary->root, nodes);
+    dictionary->root = buildBalanced(nodes, 0, (int) nodes.size() - 1);
+}
+
+/*
+Dictionary file format: one word per line, tab separated,
+    word<TAB>meaning<TAB>grammatical category<TAB>synonym<TAB>synonym<TAB>synonym
+Missing trailing fields are left empty and lines starting with '#' are ignored.
+Entries are sorted and linked median-first, so a sorted file does not degenerate the tree.
+*/
+int loadDictionary(Dictionary* dictionary, istream& in, DuplicatePolicy policy) {
+    vector<Node*> nodes;
+    string line;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        vector<string> fields = splitFields(line, '\t');
+        fields.resize(6);
+        nodes.push_back(createNode(move(fields[0]), move(fields[1]), move(fields[2]), &fields[3]));
+    }
+    return linkLoadedNodes(dictionary, nodes, policy);
+}
+
+// Moves the entry of replacement into node, which keeps its place in the tree and
+// in the accelerators, and frees replacement.
+static void replaceEntry(LazyStore* lazy, Node* node, Node* replacement) {
+    forgetEntry(lazy, node);
+    forgetEntry(lazy, replacement);
+    node->word = move(replacement->word);
+    node->meaning = move(replacement->meaning);
+    node->grammaticalCategory = move(replacement->grammaticalCategory);
+    for (int i = 0; i < 3; i++) {
+        node->synonyms[i] = move(replacement->synonyms[i]);
+    }
+    node->offset = replacement->offset;
+    delete replacement;
+}
+
+static void discardNode(LazyStore* lazy, Node* node) {
+    forgetEntry(lazy, node);
+    delete node;
+}
+
+// Adds a batch of nodes from createNode in O(n + m) after sorting the batch: the
+// tree is flattened in order, merged with the batch and rebuilt balanced. Existing
+// nodes are reused, so pointers to them stay valid. Within the batch the first copy
+// of a word wins, or the last one with REPLACE_EXISTING. Returns the words added.
+int linkLoadedNodes(Dictionary* dictionary, vector<Node*>& nodes, DuplicatePolicy policy) {
+    stable_sort(nodes.begin(), nodes.end(), [](Node* a, Node* b) {
+        return strcasecmp(a->word.c_str(), b->word.c_str()) < 0;
+    });
+    vector<Node*> batch;
+    batch.reserve(nodes.size());
+    for (Node* node : nodes) {
+        if (batch.empty() || strcasecmp(batch.back()->word.c_str(), node->word.c_str()) != 0) {
+            batch.push_back(node);
+        } else if (policy == REPLACE_EXISTING) {
+            discardNode(dictionary->lazy, batch.back());
+            batch.back() = node;
+        } else {
+            discardNode(dictionary->lazy, node);
+        }
+    }
+
+    // Tombstones would only be merged past, so they go first.
+    if (dictionary->tombstones > 0) {
+        compactTombstones(dictionary);
+    }
+    vector<Node*> existing;
+    flattenTree(dictionary->root, existing);
+    vector<Node*> merged;
+    merged.reserve(existing.size() + batch.size());
+    size_t i = 0, j = 0;
+    int added = 0;
+    while (i < existing.size() || j < batch.size()) {
+        int order = i == existing.size() ? 1
+                  : j == batch.size() ? -1
+                  : strcasecmp(existing[i]->word.c_str(), batch[j]->word.c_str());
+        if (order < 0) {
+            merged.push_back(existing[i++]);
+        } else if (order > 0) {
+            noteChange(dictionary, batch[j]->word, batch[j]);
+            merged.push_back(batch[j++]);
+            added++;
+        } else {
+            if (policy == REPLACE_EXISTING) {
+                replaceEntry(dictionary->lazy, existing[i], batch[j++]);
+                noteChange(dictionary, existing[i]->word, existing[i]);
+            } else {
+                discardNode(dictionary->lazy, batch[j++]);
+            }
+            merged.push_back(existing[i++]);
+        }
+    }
+    dictionary->root = buildBalanced(merged, 0, (int) merged.size() - 1);
+    dictionary->size = merged.size();
+    dictionary->maxSize = merged.size();
+
+    if (dictionary->filter != nullptr) {
+        rebuildBloomFilter(dictionary);
+    }
+    if (dictionary->index != nullptr) {
+        rebuildHashIndex(dictionary);
+    }
+    return added;
+}
+
+void replaceTree(Dictionary* dictionary, Node* root) {
+    vector<Node*> old;
+    flattenTree(dictionary->root, old);
+    for (Node* node : old) {
+        if (dictionary->hotCache != nullptr) {
+            hotCacheForget(dictionary->hotCache, node->word);
+        }
+        discardNode(dictionary->lazy, node);
+    }
+    dictionary->root = root;
+    dictionary->size = (size_t) countWords(root);
+    dictionary->maxSize = dictionary->size;
+    dictionary->tombstones = 0;
+
+    if (dictionary->filter != nullptr) {
+        rebuildBloomFilter(dictionary);
+    }
+    if (dictionary->index != nullptr) {
+        rebuildHashIndex(dictionary);
+    }
+    // The next snapshot rebuilds the version from the new tree.
+    if (dictionary->versions != nullptr) {
+        disableSnapshots(dictionary);
+        enableSnapshots(dictionary);
+    }
+}
+
+void saveDictionary(Node* root, ostream& out, LazyStore* lazy) {
+    if (root == nullptr) {
+        return;
+    }
+    saveDictionary(root->left, out, lazy);
+    if (!root->tombstone) {
+        materializeEntry(lazy, root);
+        writeEntry(out, *root);
+    }
+    saveDictionary(root->right, out, lazy);
+}
+
+void noteChange(Dictionary* dictionary, const string& word, Node* entry) {
+    markDirty(dictionary, word, entry);
+    recordVersion(dictionary, word);
+}
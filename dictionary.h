@@ -0,0 +1,119 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <charconv>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct Node {
+    std::string word;
+    std::string meaning;
+    std::string grammaticalCategory;
+    std::string synonyms[3];
+    // Position of the entry's line in the lazily loaded file, or -1 when meaning and synonyms are resident.
+    long long offset;
+    // Deleted in tombstone mode: still linked for the descent, skipped by every reader.
+    bool tombstone;
+    Node* left;
+    Node* right;
+};
+
+// A word's fields without tree links, for the structures built on top of the tree.
+struct WordEntry {
+    std::string word;
+    std::string meaning;
+    std::string grammaticalCategory;
+    std::string synonyms[3];
+};
+
+struct BloomFilter;
+struct CheckpointLog;
+struct FrozenDictionary;
+struct HashIndex;
+struct HotCache;
+struct LazyStore;
+struct PersistentDictionary;
+
+// What a bulk load does with a word that is already in the dictionary.
+enum DuplicatePolicy {
+    KEEP_EXISTING,
+    REPLACE_EXISTING
+};
+
+struct Dictionary {
+    Node* root = nullptr;
+    BloomFilter* filter = nullptr;
+    HotCache* hotCache = nullptr;
+    HashIndex* index = nullptr;
+    CheckpointLog* checkpoint = nullptr;
+    // Set while meanings and synonyms are read from a file on demand (see lazy.h).
+    LazyStore* lazy = nullptr;
+    // Read-only mode: served from this frozen file while the tree stays empty (see frozenview.h).
+    FrozenDictionary* frozen = nullptr;
+    // Brought up to date with the tree when a snapshot is taken (see persistent.h).
+    PersistentDictionary* versions = nullptr;
+    // Scapegoat mode when alpha > 0 and tombstone mode when tombstoneRatio > 0. size
+    // counts the linked nodes, tombstones included; it and maxSize are only kept up
+    // to date in these modes.
+    double alpha = 0;
+    double tombstoneRatio = 0;
+    size_t size = 0;
+    size_t maxSize = 0;
+    size_t tombstones = 0;
+};
+
+Node* createNode(std::string word, std::string meaning, std::string grammaticalCategory, std::string synonyms[3]);
+void insertNode(Node* root, Node* newNode);
+std::pair<Node*, bool> emplaceWord(Dictionary* dictionary, std::string word, std::string meaning, std::string grammaticalCategory, std::string synonyms[3]);
+bool addWord(Dictionary* dictionary, std::string word, std::string meaning, std::string grammaticalCategory, std::string synonyms[3]);
+void showWord(Node* word, LazyStore* lazy);
+void showWord(const WordEntry& entry);
+void deleteWord(Node*& root, std::string word, LazyStore* lazy);
+void deleteWord(Dictionary* dictionary, std::string word);
+void listByCategory(Node* root, std::string category, LazyStore* lazy);
+void listByLetter(Node* root, char letter, LazyStore* lazy);
+void listAllWords(Node* root, LazyStore* lazy);
+void showFirstAndLast(Node* root, LazyStore* lazy);
+int countWords(Node* root);
+Node* searchWord(Node* root, const std::string& word);
+Node* searchWord(Dictionary* dictionary, const std::string& word);
+// Same as searchWord(root, word), but counted under the caller's operation
+// instead of as a search of its own.
+Node* findNode(Node* root, const std::string& word);
+void destroyTree(Node* root, LazyStore* lazy);
+
+uint64_t hashWord(const std::string& word);
+std::vector<std::string> splitFields(const std::string& line, char separator);
+// Parses all of text as a T; false when it is not a number or does not fit.
+template <typename T>
+bool parseNumber(const std::string& text, T& value) {
+    const char* end = text.data() + text.size();
+    auto [last, error] = std::from_chars(text.data(), end, value);
+    return error == std::errc() && last == end;
+}
+Node* buildBalanced(std::vector<Node*>& nodes, int low, int high);
+void flattenTree(Node* root, std::vector<Node*>& nodes);
+void flattenLiveTree(Node* root, std::vector<Node*>& nodes);
+void rebuildTree(Dictionary* dictionary);
+int loadDictionary(Dictionary* dictionary, std::istream& in, DuplicatePolicy policy = KEEP_EXISTING);
+int linkLoadedNodes(Dictionary* dictionary, std::vector<Node*>& nodes, DuplicatePolicy policy = KEEP_EXISTING);
+// Frees every entry and puts root, a tree built without accelerators, in their place.
+void replaceTree(Dictionary* dictionary, Node* root);
+void saveDictionary(Node* root, std::ostream& out, LazyStore* lazy);
+// Writes one entry, a Node or a WordEntry, as a line of the dictionary file format.
+template <typename Entry>
+void writeEntry(std::ostream& out, const Entry& entry) {
+    out << entry.word << '\t' << entry.meaning << '\t' << entry.grammaticalCategory;
+    for (const std::string& synonym : entry.synonyms) {
+        out << '\t' << synonym;
+    }
+    out << '\n';
+}
+// Passes a changed word on to the checkpoint and the snapshots; entry is null for a delete.
+void noteChange(Dictionary* dictionary, const std::string& word, Node* entry);
+
+#endif
@@ -0,0 +1,184 @@
+#include "flusher.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+static bool writeAll(int fd, const string& buffer) {
+    size_t written = 0;
+    while (written < buffer.size()) {
+        ssize_t n = write(fd, buffer.data() + written, buffer.size() - written);
+        if (n < 0) {
+            return false;
+        }
+        written += (size_t) n;
+    }
+    return true;
+}
+
+static void flushPending(JournalFlusher* flusher) {
+    JournalRecord* record = flusher->pending.exchange(nullptr, memory_order_acquire);
+    if (record == nullptr) {
+        return;
+    }
+    // The list is newest first.
+    JournalRecord* ordered = nullptr;
+    size_t count = 0;
+    while (record != nullptr) {
+        JournalRecord* next = record->next;
+        record->next = ordered;
+        ordered = record;
+        record = next;
+        count++;
+    }
+    flusher->pendingCount.fetch_sub(count);
+
+    string buffer;
+    uint64_t last = 0;
+    bool ok = true;
+    while (ordered != nullptr) {
+        if (ordered->line.empty()) {
+            // O_APPEND makes the following writes start over at the new end.
+            ok = ok && writeAll(flusher->fd, buffer) && ftruncate(flusher->fd, 0) == 0;
+            buffer.clear();
+        } else {
+            buffer += ordered->line;
+        }
+        last = ordered->sequence;
+        JournalRecord* next = ordered->next;
+        delete ordered;
+        ordered = next;
+    }
+    ok = ok && writeAll(flusher->fd, buffer) && fdatasync(flusher->fd) == 0;
+
+    flusher->batches++;
+    flusher->bytes += buffer.size();
+    if (count > flusher->largestBatch) {
+        flusher->largestBatch = count;
+    }
+    {
+        lock_guard<mutex> lock(flusher->sleepLock);
+        if (ok) {
+            flusher->durable = last;
+        } else {
+            flusher->lost = last;
+        }
+        flusher->failed = !ok;
+    }
+    flusher->durableWake.notify_all();
+}
+
+static void runFlusher(JournalFlusher* flusher) {
+    unique_lock<mutex> lock(flusher->sleepLock);
+    while (true) {
+        auto due = [flusher] {
+            return flusher->stopping || flusher->urgent || flusher->pendingCount >= flusher->batchSize;
+        };
+        if (flusher->interval.count() > 0) {
+            flusher->wake.wait_for(lock, flusher->interval, due);
+        } else {
+            flusher->wake.wait(lock, due);
+        }
+        bool stop = flusher->stopping;
+        flusher->urgent = false;
+        lock.unlock();
+        flushPending(flusher);
+        lock.lock();
+        if (stop) {
+            return;
+        }
+    }
+}
+
+// The dictionary is changed by one thread at a time, so records are pushed in
+// sequence order.
+static uint64_t push(JournalFlusher* flusher, string line) {
+    uint64_t sequence = flusher->enqueued.fetch_add(1) + 1;
+    // Once pushed, the record belongs to the flusher.
+    JournalRecord* record = new JournalRecord{sequence, move(line), nullptr};
+    record->next = flusher->pending.load(memory_order_relaxed);
+    while (!flusher->pending.compare_exchange_weak(record->next, record, memory_order_release, memory_order_relaxed)) {
+    }
+    // Taking the lock once per batch keeps the notify from falling between the
+    // flusher's check and its sleep, which with no interval would never end.
+    if (flusher->pendingCount.fetch_add(1) + 1 == flusher->batchSize) {
+        {
+            lock_guard<mutex> lock(flusher->sleepLock);
+        }
+        flusher->wake.notify_one();
+    }
+    return sequence;
+}
+
+JournalFlusher* startFlusher(const string& path, chrono::milliseconds interval, size_t batchSize) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        return nullptr;
+    }
+    JournalFlusher* flusher = new JournalFlusher();
+    flusher->path = path;
+    flusher->fd = fd;
+    flusher->interval = interval;
+    flusher->batchSize = max<size_t>(batchSize, 1);
+    flusher->worker = thread(runFlusher, flusher);
+    return flusher;
+}
+
+void stopFlusher(JournalFlusher* flusher) {
+    if (flusher == nullptr) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(flusher->sleepLock);
+        flusher->stopping = true;
+    }
+    flusher->wake.notify_one();
+    flusher->worker.join();
+    close(flusher->fd);
+    delete flusher;
+}
+
+uint64_t enqueueRecord(JournalFlusher* flusher, string line) {
+    return push(flusher, move(line));
+}
+
+uint64_t enqueueTruncate(JournalFlusher* flusher) {
+    return push(flusher, "");
+}
+
+bool waitDurable(JournalFlusher* flusher, uint64_t sequence) {
+    if (flusher->durable >= sequence) {
+        return flusher->lost < sequence;
+    }
+    {
+        lock_guard<mutex> lock(flusher->sleepLock);
+        flusher->urgent = true;
+    }
+    flusher->wake.notify_one();
+    unique_lock<mutex> lock(flusher->sleepLock);
+    flusher->durableWake.wait(lock, [flusher, sequence] {
+        return flusher->durable >= sequence || flusher->lost >= sequence;
+    });
+    return flusher->durable >= sequence && flusher->lost < sequence;
+}
+
+void printFlusherStats(const JournalFlusher* flusher, ostream& out) {
+    if (flusher == nullptr) {
+        out << "The journal flusher is off.\n";
+        return;
+    }
+    uint64_t batches = flusher->batches;
+    out << "Journal " << flusher->path << ": " << flusher->enqueued << " records queued, "
+        << flusher->durable << " durable, " << batches << " flushes";
+    if (batches > 0) {
+        out << " (" << (double) flusher->bytes / batches << " bytes and up to "
+            << flusher->largestBatch << " records each)";
+    }
+    if (flusher->failed) {
+        out << ", last write failed";
+    } else if (flusher->lost > 0) {
+        out << ", records up to " << flusher->lost << " lost";
+    }
+    out << "\n";
+}
@@ -0,0 +1,66 @@
+#ifndef FLUSHER_H
+#define FLUSHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+/*
+Background journal writer. The thread that changes the dictionary only pushes each
+record onto a lock-free list and returns; it never waits for the disk. A flusher
+thread takes the whole list at once, writes it with one write and one fdatasync,
+and then publishes the sequence number of the last record as durable. It flushes
+when the interval elapses, when batchSize records are waiting, when someone waits
+for durability, and once more on stop. An interval of 0 turns the timer off, so
+only a full batch, a wait or the stop flushes.
+
+Sequence numbers count the records from 1. waitDurable blocks until every record up
+to a sequence is on disk, for callers that must not answer before that.
+*/
+struct JournalRecord {
+    uint64_t sequence;
+    // Empty for a truncate marker: the records before it are no longer needed.
+    std::string line;
+    JournalRecord* next;
+};
+
+struct JournalFlusher {
+    std::string path;
+    int fd = -1;
+    std::chrono::milliseconds interval{0};
+    size_t batchSize = 1;
+    std::atomic<JournalRecord*> pending{nullptr};
+    std::atomic<size_t> pendingCount{0};
+    std::atomic<uint64_t> enqueued{0};
+    std::atomic<uint64_t> durable{0};
+    std::atomic<bool> urgent{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> failed{false};
+    std::atomic<uint64_t> lost{0};
+    std::atomic<uint64_t> batches{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> largestBatch{0};
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::condition_variable durableWake;
+    std::thread worker;
+};
+
+// Appends to the journal at path; nullptr when it cannot be opened.
+JournalFlusher* startFlusher(const std::string& path, std::chrono::milliseconds interval, size_t batchSize);
+// Flushes what is still queued, then joins the thread and frees the flusher.
+void stopFlusher(JournalFlusher* flusher);
+// line must end with a newline. Returns the record's sequence number.
+uint64_t enqueueRecord(JournalFlusher* flusher, std::string line);
+// Empties the journal once the records queued before it are written.
+uint64_t enqueueTruncate(JournalFlusher* flusher);
+// False when a record up to sequence could not be written.
+bool waitDurable(JournalFlusher* flusher, uint64_t sequence);
+void printFlusherStats(const JournalFlusher* flusher, std::ostream& out);
+
+#endif
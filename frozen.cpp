@@ -0,0 +1,513 @@
+#include "frozen.h"
+
+#include <algorithm>
+#include <strings.h>
+
+#include "lazy.h"
+
+using namespace std;
+
+static const char frozenMagic[8] = {'D', 'I', 'C', 'T', 'F', 'C', '3', '\n'};
+static const char frozenMagicV2[8] = {'D', 'I', 'C', 'T', 'F', 'C', '2', '\n'};
+static const char frozenMagicV1[8] = {'D', 'I', 'C', 'T', 'F', 'C', '1', '\n'};
+static const uint32_t flagCompressedMeanings = 1;
+// Meanings sampled for training the symbol table.
+static const size_t trainingSampleBytes = 64 * 1024;
+
+static void putVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char) (value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char) value);
+}
+
+static uint64_t getVarint(const string& in, size_t& position) {
+    uint64_t value = 0;
+    int shift = 0;
+    while (true) {
+        uint8_t byte = (uint8_t) in[position++];
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+        shift += 7;
+    }
+}
+
+static void putField(string& out, const string& field) {
+    putVarint(out, field.size());
+    out.append(field);
+}
+
+static string getField(const string& in, size_t& position) {
+    size_t length = getVarint(in, position);
+    string field = in.substr(position, length);
+    position += length;
+    return field;
+}
+
+// Decodes keys sequentially, reusing the previous key as the shared prefix.
+struct KeyCursor {
+    const FrozenDictionary& frozen;
+    size_t position;
+    long ordinal;
+    string key;
+
+    KeyCursor(const FrozenDictionary& frozen, long block)
+        : frozen(frozen), position(frozen.restarts[block]), ordinal(block * (long) frozen.restartInterval) {}
+
+    bool next() {
+        if (ordinal >= (long) frozen.count) {
+            return false;
+        }
+        size_t shared = getVarint(frozen.keys, position);
+        size_t unshared = getVarint(frozen.keys, position);
+        key.resize(shared);
+        key.append(frozen.keys, position, unshared);
+        position += unshared;
+        return true;
+    }
+};
+
+static void materialize(LazyStore* lazy, Node* node) {
+    materializeEntry(lazy, node);
+}
+
+static void materialize(LazyStore*, const WordEntry*) {
+}
+
+template <typename Entry>
+static vector<string> sampleMeanings(const vector<Entry*>& nodes, LazyStore* lazy) {
+    uint64_t total = 0;
+    for (Entry* node : nodes) {
+        materialize(lazy, node);
+        total += node->meaning.size();
+    }
+    size_t stride = max<uint64_t>(1, total / trainingSampleBytes);
+    vector<string> sample;
+    for (size_t i = 0; i < nodes.size(); i += stride) {
+        materialize(lazy, nodes[i]);
+        sample.push_back(nodes[i]->meaning);
+    }
+    return sample;
+}
+
+// Entry is Node or WordEntry; nodes are in alphabetical order.
+template <typename Entry>
+static FrozenDictionary freezeSorted(const vector<Entry*>& nodes, LazyStore* lazy, uint32_t restartInterval,
+                                     bool compressMeanings) {
+    FrozenDictionary frozen;
+    frozen.restartInterval = restartInterval > 0 ? restartInterval : 1;
+    frozen.count = nodes.size();
+    if (compressMeanings) {
+        vector<string> sample = sampleMeanings(nodes, lazy);
+        frozen.meaningTable = trainSymbolTable(vector<string_view>(sample.begin(), sample.end()));
+        frozen.compressedMeanings = true;
+    }
+    string compressed;
+    frozen.payloadOffsets.reserve(nodes.size());
+    const string* previous = nullptr;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        Entry* node = nodes[i];
+        size_t shared = 0;
+        if (i % frozen.restartInterval == 0) {
+            frozen.restarts.push_back(frozen.keys.size());
+        } else {
+            size_t limit = min(previous->size(), node->word.size());
+            while (shared < limit && (*previous)[shared] == node->word[shared]) {
+                shared++;
+            }
+        }
+        putVarint(frozen.keys, shared);
+        putVarint(frozen.keys, node->word.size() - shared);
+        frozen.keys.append(node->word, shared, string::npos);
+        previous = &node->word;
+
+        materialize(lazy, node);
+        frozen.payloadOffsets.push_back(frozen.payload.size());
+        if (frozen.compressedMeanings) {
+            compressed.clear();
+            compressText(frozen.meaningTable, node->meaning, compressed);
+            putVarint(frozen.payload, node->meaning.size());
+            putField(frozen.payload, compressed);
+        } else {
+            putField(frozen.payload, node->meaning);
+        }
+        putField(frozen.payload, node->grammaticalCategory);
+        for (const string& synonym : node->synonyms) {
+            putField(frozen.payload, synonym);
+        }
+    }
+    return frozen;
+}
+
+FrozenDictionary freezeTree(Node* root, LazyStore* lazy, uint32_t restartInterval, bool compressMeanings) {
+    vector<Node*> nodes;
+    flattenLiveTree(root, nodes);
+    return freezeSorted(nodes, lazy, restartInterval, compressMeanings);
+}
+
+FrozenDictionary freezeEntries(const vector<const WordEntry*>& entries, uint32_t restartInterval,
+                               bool compressMeanings) {
+    return freezeSorted(entries, nullptr, restartInterval, compressMeanings);
+}
+
+// Keys at a restart share nothing, so they can be compared in place.
+static int compareRestartKey(const FrozenDictionary& frozen, long block, const string& word) {
+    size_t position = frozen.restarts[block];
+    getVarint(frozen.keys, position);
+    size_t length = getVarint(frozen.keys, position);
+    int order = strncasecmp(frozen.keys.data() + position, word.c_str(), min(length, word.size()));
+    if (order != 0 || length == word.size()) {
+        return order;
+    }
+    return length < word.size() ? -1 : 1;
+}
+
+static long lowerBound(const FrozenDictionary& frozen, const string& word, bool& exact) {
+    exact = false;
+    if (frozen.count == 0) {
+        return 0;
+    }
+    // Last block whose first key is <= word; the answer is in it or starts the next one.
+    long low = 0;
+    long high = (long) frozen.restarts.size() - 1;
+    while (low < high) {
+        long middle = low + (high - low + 1) / 2;
+        if (compareRestartKey(frozen, middle, word) <= 0) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+    KeyCursor cursor(frozen, low);
+    long blockEnd = min((long) frozen.count, (low + 1) * (long) frozen.restartInterval);
+    while (cursor.ordinal < blockEnd && cursor.next()) {
+        int order = strcasecmp(cursor.key.c_str(), word.c_str());
+        if (order >= 0) {
+            exact = order == 0;
+            return cursor.ordinal;
+        }
+        cursor.ordinal++;
+    }
+    return blockEnd;
+}
+
+// Ordinal of the first key not alphabetically before word (count when there is none).
+long lowerBoundFrozen(const FrozenDictionary& frozen, const string& word) {
+    bool exact;
+    return lowerBound(frozen, word, exact);
+}
+
+long findFrozen(const FrozenDictionary& frozen, const string& word) {
+    bool exact;
+    long ordinal = lowerBound(frozen, word, exact);
+    return exact ? ordinal : -1;
+}
+
+static string frozenKey(const FrozenDictionary& frozen, long ordinal) {
+    KeyCursor cursor(frozen, ordinal / frozen.restartInterval);
+    while (cursor.next() && cursor.ordinal < ordinal) {
+        cursor.ordinal++;
+    }
+    return cursor.key;
+}
+
+static WordEntry decodeEntry(const FrozenDictionary& frozen, long ordinal, string word) {
+    WordEntry entry;
+    entry.word = move(word);
+    size_t position = frozen.payloadOffsets[ordinal];
+    if (frozen.compressedMeanings) {
+        size_t originalSize = getVarint(frozen.payload, position);
+        size_t compressedSize = getVarint(frozen.payload, position);
+        decompressText(frozen.meaningTable, frozen.payload.data() + position, compressedSize, originalSize, entry.meaning);
+        position += compressedSize;
+    } else {
+        entry.meaning = getField(frozen.payload, position);
+    }
+    entry.grammaticalCategory = getField(frozen.payload, position);
+    for (string& synonym : entry.synonyms) {
+        synonym = getField(frozen.payload, position);
+    }
+    return entry;
+}
+
+WordEntry frozenEntry(const FrozenDictionary& frozen, long ordinal) {
+    return decodeEntry(frozen, ordinal, frozenKey(frozen, ordinal));
+}
+
+// Visits the entries from ordinal first on, in order, until visit returns false.
+void forEachFrozen(const FrozenDictionary& frozen, long first, const function<bool(const WordEntry&)>& visit) {
+    if (first < 0 || first >= (long) frozen.count) {
+        return;
+    }
+    KeyCursor cursor(frozen, first / frozen.restartInterval);
+    while (cursor.next()) {
+        if (cursor.ordinal >= first && !visit(decodeEntry(frozen, cursor.ordinal, cursor.key))) {
+            return;
+        }
+        cursor.ordinal++;
+    }
+}
+
+// Visits, in order, every entry whose word starts with prefix (ignoring case).
+void forEachFrozenPrefix(const FrozenDictionary& frozen, const string& prefix,
+                         const function<void(const WordEntry&)>& visit) {
+    forEachFrozen(frozen, lowerBoundFrozen(frozen, prefix), [&](const WordEntry& entry) {
+        if (strncasecmp(entry.word.c_str(), prefix.c_str(), prefix.size()) != 0) {
+            return false;
+        }
+        visit(entry);
+        return true;
+    });
+}
+
+template <typename T>
+static void writePod(ostream& out, T value) {
+    out.write((const char*) &value, sizeof(T));
+}
+
+template <typename T>
+static bool readPod(istream& in, T& value) {
+    return (bool) in.read((char*) &value, sizeof(T));
+}
+
+static void writeBytes(ostream& out, const string& bytes) {
+    writePod<uint64_t>(out, bytes.size());
+    out.write(bytes.data(), (streamsize) bytes.size());
+}
+
+static bool readArray(istream& in, char* data, uint64_t size) {
+    return (bool) in.read(data, (streamsize) size);
+}
+
+// Grows the buffer as data actually arrives, so a corrupt size cannot allocate much
+// more than the file holds.
+static bool readBytes(istream& in, string& bytes) {
+    static const uint64_t chunk = 1 << 20;
+    uint64_t size;
+    if (!readPod(in, size)) {
+        return false;
+    }
+    bytes.clear();
+    while (bytes.size() < size) {
+        size_t start = bytes.size();
+        bytes.resize(start + min(chunk, size - start));
+        if (!readArray(in, bytes.data() + start, bytes.size() - start)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// getVarint with bounds and overflow checks, for validating untrusted input.
+static bool checkedVarint(const string& in, size_t& position, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position >= in.size()) {
+            return false;
+        }
+        uint8_t byte = (uint8_t) in[position++];
+        value |= (uint64_t) (byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool checkedField(const string& in, size_t& position, size_t end, uint64_t& length) {
+    if (!checkedVarint(in, position, length) || length > end - min(position, end)) {
+        return false;
+    }
+    position += length;
+    return true;
+}
+
+/*
+Walks every key and payload of a loaded file once with bounds checks, so that the
+unchecked decoders above can trust it: restarts must sit exactly at the keys that
+start a block and share nothing, every shared prefix must fit the previous key, and
+every payload must lie within its own slice of the payload bytes.
+*/
+static bool validateFrozen(const FrozenDictionary& frozen) {
+    size_t position = 0;
+    uint64_t previousLength = 0;
+    for (uint64_t ordinal = 0; ordinal < frozen.count; ordinal++) {
+        uint64_t shared, unshared;
+        bool restart = ordinal % frozen.restartInterval == 0;
+        if (restart && frozen.restarts[ordinal / frozen.restartInterval] != position) {
+            return false;
+        }
+        if (!checkedVarint(frozen.keys, position, shared) || shared > previousLength || (restart && shared != 0)
+            || !checkedField(frozen.keys, position, frozen.keys.size(), unshared)) {
+            return false;
+        }
+        previousLength = shared + unshared;
+    }
+    if (position != frozen.keys.size()) {
+        return false;
+    }
+
+    for (uint64_t ordinal = 0; ordinal < frozen.count; ordinal++) {
+        size_t start = frozen.payloadOffsets[ordinal];
+        size_t end = ordinal + 1 < frozen.count ? frozen.payloadOffsets[ordinal + 1] : frozen.payload.size();
+        if (start > end || end > frozen.payload.size()) {
+            return false;
+        }
+        size_t cursor = start;
+        uint64_t length;
+        if (frozen.compressedMeanings) {
+            // Each code expands to at most eight bytes.
+            uint64_t originalSize;
+            if (!checkedVarint(frozen.payload, cursor, originalSize) || !checkedField(frozen.payload, cursor, end, length)
+                || originalSize > 8 * length) {
+                return false;
+            }
+        } else if (!checkedField(frozen.payload, cursor, end, length)) {
+            return false;
+        }
+        for (int field = 0; field < 4; field++) {
+            if (!checkedField(frozen.payload, cursor, end, length)) {
+                return false;
+            }
+        }
+        if (cursor != end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Checks the magic without consuming it.
+bool isFrozenFile(istream& in) {
+    char magic[sizeof(frozenMagic)] = {};
+    streampos start = in.tellg();
+    in.read(magic, sizeof(magic));
+    bool frozen = in.gcount() == sizeof(magic)
+                  && (equal(magic, magic + sizeof(magic), frozenMagic) || equal(magic, magic + sizeof(magic), frozenMagicV2)
+                      || equal(magic, magic + sizeof(magic), frozenMagicV1));
+    in.clear();
+    in.seekg(start);
+    return frozen;
+}
+
+void saveFrozen(const FrozenDictionary& frozen, ostream& out) {
+    out.write(frozenMagic, sizeof(frozenMagic));
+    writePod<uint32_t>(out, frozen.compressedMeanings ? flagCompressedMeanings : 0);
+    if (frozen.compressedMeanings) {
+        const SymbolTable& table = frozen.meaningTable;
+        writePod<uint32_t>(out, (uint32_t) table.count);
+        out.write((const char*) table.lengths, table.count);
+        out.write((const char*) table.symbols, (streamsize) (table.count * sizeof(uint64_t)));
+    }
+    writePod<uint32_t>(out, frozen.restartInterval);
+    writePod<uint64_t>(out, frozen.count);
+    writeBytes(out, frozen.keys);
+    writePod<uint64_t>(out, frozen.restarts.size());
+    out.write((const char*) frozen.restarts.data(), (streamsize) (frozen.restarts.size() * sizeof(uint64_t)));
+    writeBytes(out, frozen.payload);
+    out.write((const char*) frozen.payloadOffsets.data(), (streamsize) (frozen.count * sizeof(uint64_t)));
+}
+
+bool loadFrozen(FrozenDictionary& frozen, istream& in) {
+    char magic[sizeof(frozenMagic)];
+    if (!in.read(magic, sizeof(magic))) {
+        return false;
+    }
+    // Version 1 has no flags, and versions 1 and 2 store restarts as u32.
+    bool wideRestarts = equal(magic, magic + sizeof(magic), frozenMagic);
+    if (wideRestarts || equal(magic, magic + sizeof(magic), frozenMagicV2)) {
+        uint32_t flags;
+        if (!readPod(in, flags)) {
+            return false;
+        }
+        frozen.compressedMeanings = (flags & flagCompressedMeanings) != 0;
+        if (frozen.compressedMeanings) {
+            SymbolTable& table = frozen.meaningTable;
+            uint32_t count;
+            if (!readPod(in, count) || count > 255) {
+                return false;
+            }
+            table.count = (int) count;
+            if (!readArray(in, (char*) table.lengths, count)
+                || !readArray(in, (char*) table.symbols, count * sizeof(uint64_t))) {
+                return false;
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                if (table.lengths[i] < 1 || table.lengths[i] > 8) {
+                    return false;
+                }
+            }
+            table.rebuildIndex();
+        }
+    } else if (!equal(magic, magic + sizeof(magic), frozenMagicV1)) {
+        return false;
+    }
+    // Every key takes at least two bytes, which bounds count before anything is sized by it.
+    uint64_t restartCount;
+    if (!readPod(in, frozen.restartInterval) || frozen.restartInterval == 0 || !readPod(in, frozen.count)
+        || !readBytes(in, frozen.keys) || frozen.count > frozen.keys.size() / 2 || !readPod(in, restartCount)
+        || restartCount != (frozen.count + frozen.restartInterval - 1) / frozen.restartInterval) {
+        return false;
+    }
+    frozen.restarts.resize(restartCount);
+    if (wideRestarts) {
+        if (!readArray(in, (char*) frozen.restarts.data(), restartCount * sizeof(uint64_t))) {
+            return false;
+        }
+    } else {
+        vector<uint32_t> narrow(restartCount);
+        if (!readArray(in, (char*) narrow.data(), restartCount * sizeof(uint32_t))) {
+            return false;
+        }
+        copy(narrow.begin(), narrow.end(), frozen.restarts.begin());
+    }
+    if (!readBytes(in, frozen.payload)) {
+        return false;
+    }
+    frozen.payloadOffsets.resize(frozen.count);
+    if (!readArray(in, (char*) frozen.payloadOffsets.data(), frozen.count * sizeof(uint64_t))) {
+        return false;
+    }
+    return validateFrozen(frozen);
+}
+
+// Thaws a frozen file into the mutable tree.
+int loadFrozenDictionary(Dictionary* dictionary, istream& in, DuplicatePolicy policy) {
+    FrozenDictionary frozen;
+    if (!loadFrozen(frozen, in)) {
+        return -1;
+    }
+    vector<Node*> nodes;
+    nodes.reserve(frozen.count);
+    forEachFrozenPrefix(frozen, "", [&nodes](const WordEntry& entry) {
+        string synonyms[3] = {entry.synonyms[0], entry.synonyms[1], entry.synonyms[2]};
+        nodes.push_back(createNode(entry.word, entry.meaning, entry.grammaticalCategory, synonyms));
+    });
+    return linkLoadedNodes(dictionary, nodes, policy);
+}
+
+void printFrozenStats(const FrozenDictionary& frozen, ostream& out) {
+    uint64_t rawKeyBytes = 0;
+    forEachFrozenPrefix(frozen, "", [&rawKeyBytes](const WordEntry& entry) {
+        // What the tree spends per key: the std::string object plus its heap buffer when not inline.
+        rawKeyBytes += sizeof(string) + (entry.word.size() >= sizeof(string) / 2 ? entry.word.size() + 1 : 0);
+    });
+    uint64_t frozenKeyBytes = frozen.keys.size() + frozen.restarts.size() * sizeof(uint64_t);
+    out << "Frozen words: " << frozen.count << "\n";
+    out << "Key bytes: " << frozenKeyBytes << " front-coded, " << rawKeyBytes << " as std::string\n";
+    out << "Payload bytes: " << frozen.payload.size() + frozen.payloadOffsets.size() * sizeof(uint64_t) << "\n";
+    if (frozen.compressedMeanings) {
+        uint64_t originalBytes = 0;
+        uint64_t compressedBytes = 0;
+        for (uint64_t offset : frozen.payloadOffsets) {
+            size_t position = offset;
+            originalBytes += getVarint(frozen.payload, position);
+            compressedBytes += getVarint(frozen.payload, position);
+        }
+        out << "Meaning bytes: " << compressedBytes << " compressed, " << originalBytes << " original ("
+            << frozen.meaningTable.count << " symbols)\n";
+    }
+}
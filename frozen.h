@@ -0,0 +1,66 @@
+#ifndef FROZEN_H
+#define FROZEN_H
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "compress.h"
+#include "dictionary.h"
+
+/*
+Frozen, read-only snapshot of the dictionary in alphabetical order.
+
+Keys are front-coded: each key stores only the length of the prefix it shares with
+the previous key and the remaining bytes. Every restartInterval keys a block starts
+with a full key; lookups binary search the block starts and then scan one block.
+
+Per entry:  varint shared length, varint suffix length, suffix bytes
+Payload:    varint length + bytes for meaning, category and the three synonyms
+
+When meanings are compressed, the meaning field is instead the varint original
+length, the varint compressed length and the compressed bytes (see compress.h),
+so any single entry can still be decoded on its own.
+
+File format (host byte order):
+    "DICTFC3\n", u32 flags (1 = compressed meanings),
+    [u32 symbol count, u8 lengths[count], u64 symbols[count]] when compressed,
+    u32 restart interval, u64 count,
+    u64 key bytes, keys, u64 restart count, u64 restarts[],
+    u64 payload bytes, payload, u64 payload offsets[count]
+Files written with the "DICTFC2\n" magic store u32 restarts, and those with
+"DICTFC1\n" also have no flags and no symbol table; both still load.
+*/
+
+struct FrozenDictionary {
+    uint32_t restartInterval = 16;
+    uint64_t count = 0;
+    bool compressedMeanings = false;
+    SymbolTable meaningTable;
+    std::string keys;
+    std::vector<uint64_t> restarts;
+    std::string payload;
+    std::vector<uint64_t> payloadOffsets;
+};
+
+FrozenDictionary freezeTree(Node* root, LazyStore* lazy, uint32_t restartInterval = 16, bool compressMeanings = true);
+// entries must be in alphabetical order, e.g. a snapshot's (see persistent.h).
+FrozenDictionary freezeEntries(const std::vector<const WordEntry*>& entries, uint32_t restartInterval = 16,
+                               bool compressMeanings = true);
+long findFrozen(const FrozenDictionary& frozen, const std::string& word);
+long lowerBoundFrozen(const FrozenDictionary& frozen, const std::string& word);
+WordEntry frozenEntry(const FrozenDictionary& frozen, long ordinal);
+void forEachFrozen(const FrozenDictionary& frozen, long first, const std::function<bool(const WordEntry&)>& visit);
+void forEachFrozenPrefix(const FrozenDictionary& frozen, const std::string& prefix,
+                         const std::function<void(const WordEntry&)>& visit);
+
+bool isFrozenFile(std::istream& in);
+void saveFrozen(const FrozenDictionary& frozen, std::ostream& out);
+bool loadFrozen(FrozenDictionary& frozen, std::istream& in);
+int loadFrozenDictionary(Dictionary* dictionary, std::istream& in, DuplicatePolicy policy = KEEP_EXISTING);
+void printFrozenStats(const FrozenDictionary& frozen, std::ostream& out);
+
+#endif
@@ -0,0 +1,119 @@
+#include "frozenview.h"
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <strings.h>
+
+using namespace std;
+
+long openFrozenDictionary(Dictionary* dictionary, const string& path) {
+    ifstream in(path, ios::binary);
+    FrozenDictionary* frozen = new FrozenDictionary();
+    if (!in || !loadFrozen(*frozen, in)) {
+        delete frozen;
+        return -1;
+    }
+    closeFrozenDictionary(dictionary);
+    dictionary->frozen = frozen;
+    return (long) frozen->count;
+}
+
+void closeFrozenDictionary(Dictionary* dictionary) {
+    delete dictionary->frozen;
+    dictionary->frozen = nullptr;
+}
+
+bool showFrozenWord(const FrozenDictionary& frozen, const string& word) {
+    long ordinal = findFrozen(frozen, word);
+    if (ordinal < 0) {
+        return false;
+    }
+    showWord(frozenEntry(frozen, ordinal));
+    return true;
+}
+
+void listFrozenByCategory(const FrozenDictionary& frozen, const string& category) {
+    forEachFrozen(frozen, 0, [&category](const WordEntry& entry) {
+        if (entry.grammaticalCategory == category) {
+            showWord(entry);
+        }
+        return true;
+    });
+}
+
+void listFrozenByLetter(const FrozenDictionary& frozen, char letter) {
+    forEachFrozenPrefix(frozen, string(1, letter), [letter](const WordEntry& entry) {
+        if (entry.word[0] == letter) {
+            showWord(entry);
+        }
+    });
+}
+
+void listAllFrozen(const FrozenDictionary& frozen) {
+    forEachFrozen(frozen, 0, [](const WordEntry& entry) {
+        showWord(entry);
+        return true;
+    });
+}
+
+void showFrozenFirstAndLast(const FrozenDictionary& frozen) {
+    if (frozen.count == 0) {
+        cout << "Dictionary is empty.\n";
+        return;
+    }
+    WordEntry first = frozenEntry(frozen, 0);
+    WordEntry last = frozenEntry(frozen, (long) frozen.count - 1);
+    cout << "First word: " << first.word << "\n";
+    showWord(first);
+    cout << "Last word: " << last.word << "\n";
+    showWord(last);
+}
+
+void saveFrozenAsText(const FrozenDictionary& frozen, ostream& out) {
+    forEachFrozen(frozen, 0, [&out](const WordEntry& entry) {
+        writeEntry(out, entry);
+        return true;
+    });
+}
+
+size_t showFrozenPage(const FrozenDictionary& frozen, ListingCursor& cursor, size_t pageSize) {
+    long first = 0;
+    if (!cursor.after.empty()) {
+        long found = findFrozen(frozen, cursor.after);
+        first = found >= 0 ? found + 1 : lowerBoundFrozen(frozen, cursor.after);
+    }
+    string letter(1, cursor.letter);
+    int folded = tolower((unsigned char) cursor.letter);
+    if (cursor.kind == LISTING_LETTER
+        && (cursor.after.empty() || strcasecmp(cursor.after.c_str(), letter.c_str()) < 0)) {
+        first = lowerBoundFrozen(frozen, letter);
+    }
+
+    size_t shown = 0;
+    bool more = false;
+    forEachFrozen(frozen, first, [&](const WordEntry& entry) {
+        bool matches = true;
+        if (cursor.kind == LISTING_CATEGORY) {
+            matches = entry.grammaticalCategory == cursor.category;
+        } else if (cursor.kind == LISTING_LETTER) {
+            if (tolower((unsigned char) entry.word[0]) != folded) {
+                return false;
+            }
+            matches = entry.word[0] == cursor.letter;
+        }
+        if (!matches) {
+            return true;
+        }
+        if (shown == pageSize) {
+            more = true;
+            return false;
+        }
+        showWord(entry);
+        cursor.after = entry.word;
+        shown++;
+        return true;
+    });
+    cursor.finished = !more;
+    return shown;
+}
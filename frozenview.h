@@ -0,0 +1,33 @@
+#ifndef FROZENVIEW_H
+#define FROZENVIEW_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+#include "frozen.h"
+#include "paging.h"
+
+/*
+Read-only dictionary served straight from a frozen file (--frozen). The tree stays
+empty: lookups binary search the restarts and scan one block, the letter listing
+and paging seek with the same search, and every entry is decoded only when it is
+shown. Keys therefore stay front-coded in memory instead of one std::string each.
+Commands that would change the dictionary are refused.
+*/
+
+// Returns the number of words, or -1 when path is not a valid frozen file.
+long openFrozenDictionary(Dictionary* dictionary, const std::string& path);
+void closeFrozenDictionary(Dictionary* dictionary);
+
+bool showFrozenWord(const FrozenDictionary& frozen, const std::string& word);
+void listFrozenByCategory(const FrozenDictionary& frozen, const std::string& category);
+void listFrozenByLetter(const FrozenDictionary& frozen, char letter);
+void listAllFrozen(const FrozenDictionary& frozen);
+void showFrozenFirstAndLast(const FrozenDictionary& frozen);
+// Writes the text format read by loadDictionary.
+void saveFrozenAsText(const FrozenDictionary& frozen, std::ostream& out);
+// Same contract as showPage (see paging.h).
+size_t showFrozenPage(const FrozenDictionary& frozen, ListingCursor& cursor, size_t pageSize);
+
+#endif
@@ -0,0 +1,391 @@
+/*
+Synthetic Spanish-like corpus and access-trace generator.
+
+Writes a dictionary file in the format read by --load / loadDictionary and,
+optionally, an operation trace in the batch command format read by --batch.
+
+Words are built from Spanish syllables with common prefixes (des-, re-, in-...)
+and category-specific endings (-ar/-er/-ir verbs, -mente adverbs, -oso/-ble
+adjectives, -cion/-dad nouns). Meanings are 4 to 20 words drawn with a Zipf skew
+from a vocabulary of function words and other dictionary words; each entry gets
+0 to 3 synonyms of the same category.
+
+The trace mixes Zipf-skewed reads (show) over the live words with bursts of
+inserts of new words, deletes, modifies and occasional listings.
+
+Usage: generator [--words 10000] [--seed 1] [--dict dictionary.tsv]
+                 [--trace trace.tsv] [--ops 100000] [--zipf 0.99]
+                 [--read-ratio 0.90] [--insert-ratio 0.05] [--delete-ratio 0.03]
+                 [--burst 50]
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+struct GeneratorConfig {
+    size_t words = 10000;
+    unsigned seed = 1;
+    string dictPath = "dictionary.tsv";
+    string tracePath;
+    size_t ops = 100000;
+    double zipf = 0.99;
+    double readRatio = 0.90;
+    double insertRatio = 0.05;
+    double deleteRatio = 0.03;
+    size_t burst = 50;
+};
+
+struct GeneratedWord {
+    string word;
+    string meaning;
+    string category;
+    string synonyms[3];
+};
+
+static const vector<string> onsets = {
+    "b", "c", "d", "f", "g", "l", "m", "n", "p", "r", "s", "t", "v", "ch", "ll", "br",
+    "tr", "pl", "pr", "cr", "gr", "fl", "j", "qu", "z", "", ""};
+static const vector<string> vowels = {"a", "e", "i", "o", "u", "a", "e", "o", "ia", "ue"};
+static const vector<string> codas = {"", "", "", "", "n", "s", "r", "l"};
+static const vector<string> prefixes = {"des", "re", "in", "con", "pre", "sub", "trans", "anti", "sobre", "entre"};
+static const vector<string> functionWords = {
+    "de", "la", "que", "el", "en", "y", "a", "los", "se", "del", "las", "un", "por", "con",
+    "una", "para", "es", "al", "lo", "como", "mas", "o", "pero", "sus", "le", "accion", "efecto"};
+
+// Grammatical category shares follow a typical general-purpose Spanish dictionary.
+static const vector<pair<string, double>> categoryShares = {
+    {"noun", 0.50}, {"verb", 0.20}, {"adjective", 0.18}, {"adverb", 0.05}, {"other", 0.07}};
+
+class ZipfSampler {
+public:
+    ZipfSampler(size_t n, double s) : cdf(max<size_t>(n, 1)) {
+        double sum = 0;
+        for (size_t i = 0; i < cdf.size(); i++) {
+            sum += 1.0 / pow((double) (i + 1), s);
+            cdf[i] = sum;
+        }
+        for (double& value : cdf) {
+            value /= sum;
+        }
+    }
+
+    size_t operator()(mt19937_64& rng) {
+        double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+        return min((size_t) (lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin()), cdf.size() - 1);
+    }
+
+    size_t size() const {
+        return cdf.size();
+    }
+
+private:
+    vector<double> cdf;
+};
+
+template <typename T>
+const T& pick(const vector<T>& items, mt19937_64& rng) {
+    return items[uniform_int_distribution<size_t>(0, items.size() - 1)(rng)];
+}
+
+string pickCategory(mt19937_64& rng) {
+    double u = uniform_real_distribution<double>(0.0, 1.0)(rng);
+    for (const auto& [category, share] : categoryShares) {
+        if (u < share) {
+            return category;
+        }
+        u -= share;
+    }
+    return categoryShares.back().first;
+}
+
+// Two or three syllables are the most common stem lengths.
+string makeStem(mt19937_64& rng) {
+    static const vector<int> syllableCounts = {1, 2, 2, 2, 3, 3, 3, 4};
+    int syllables = pick(syllableCounts, rng);
+    string stem;
+    if (uniform_int_distribution<int>(0, 9)(rng) == 0) {
+        stem += pick(prefixes, rng);
+    }
+    for (int i = 0; i < syllables; i++) {
+        stem += pick(onsets, rng);
+        stem += pick(vowels, rng);
+        if (i + 1 < syllables || uniform_int_distribution<int>(0, 2)(rng) == 0) {
+            stem += pick(codas, rng);
+        }
+    }
+    return stem;
+}
+
+string makeWord(const string& category, mt19937_64& rng) {
+    static const vector<string> verbEndings = {"ar", "ar", "ar", "er", "ir"};
+    static const vector<string> adjectiveEndings = {"oso", "ble", "al", "ico", "ado", "ente"};
+    static const vector<string> nounEndings = {"cion", "dad", "miento", "o", "a", "e", "ista", "aje"};
+    string stem = makeStem(rng);
+    if (category == "verb") {
+        return stem + pick(verbEndings, rng);
+    }
+    if (category == "adjective") {
+        return stem + pick(adjectiveEndings, rng);
+    }
+    if (category == "adverb") {
+        return stem + "amente";
+    }
+    if (category == "noun") {
+        return stem + pick(nounEndings, rng);
+    }
+    return stem;
+}
+
+vector<GeneratedWord> generateWords(size_t count, unordered_set<string>& used, mt19937_64& rng) {
+    vector<GeneratedWord> words;
+    words.reserve(count);
+    while (words.size() < count) {
+        GeneratedWord entry;
+        entry.category = pickCategory(rng);
+        entry.word = makeWord(entry.category, rng);
+        if (used.insert(entry.word).second) {
+            words.push_back(entry);
+        }
+    }
+    return words;
+}
+
+// Function words first so the Zipf skew makes them the most frequent in meanings.
+vector<string> buildVocabulary(const vector<GeneratedWord>& words) {
+    vector<string> vocabulary = functionWords;
+    for (size_t i = 0; i < words.size() && i < 5000; i++) {
+        vocabulary.push_back(words[i].word);
+    }
+    return vocabulary;
+}
+
+static const vector<int> synonymCounts = {0, 0, 0, 1, 1, 1, 2, 2, 2, 3};
+
+void fillMeaning(GeneratedWord& entry, const vector<string>& vocabulary, ZipfSampler& vocabularySampler,
+                 mt19937_64& rng) {
+    int length = uniform_int_distribution<int>(4, 20)(rng);
+    for (int i = 0; i < length; i++) {
+        if (i > 0) {
+            entry.meaning += ' ';
+        }
+        entry.meaning += vocabulary[vocabularySampler(rng)];
+    }
+}
+
+void fillMeaningsAndSynonyms(vector<GeneratedWord>& words, const vector<string>& vocabulary,
+                             double zipfExponent, mt19937_64& rng) {
+    ZipfSampler vocabularySampler(vocabulary.size(), zipfExponent);
+
+    vector<vector<size_t>> byCategory(categoryShares.size());
+    for (size_t i = 0; i < words.size(); i++) {
+        for (size_t c = 0; c < categoryShares.size(); c++) {
+            if (categoryShares[c].first == words[i].category) {
+                byCategory[c].push_back(i);
+            }
+        }
+    }
+
+    for (GeneratedWord& entry : words) {
+        fillMeaning(entry, vocabulary, vocabularySampler, rng);
+
+        const vector<size_t>* sameCategory = nullptr;
+        for (size_t c = 0; c < categoryShares.size(); c++) {
+            if (categoryShares[c].first == entry.category) {
+                sameCategory = &byCategory[c];
+            }
+        }
+        // The category holds the word itself, so it can give at most size - 1 distinct synonyms.
+        size_t synonyms = sameCategory == nullptr ? 0 : min<size_t>(pick(synonymCounts, rng), sameCategory->size() - 1);
+        for (size_t i = 0; i < synonyms;) {
+            const string& candidate = words[pick(*sameCategory, rng)].word;
+            // Redraw the word itself and synonyms it already has, so the slots fill in order.
+            if (candidate != entry.word && find(entry.synonyms, entry.synonyms + i, candidate) == entry.synonyms + i) {
+                entry.synonyms[i++] = candidate;
+            }
+        }
+    }
+}
+
+// Synonyms for a word the trace adds, drawn from the live words of its category. Every
+// category is a sizeable share of the words, so a few random draws usually find them.
+void pickLiveSynonyms(GeneratedWord& entry, const vector<GeneratedWord>& live, mt19937_64& rng) {
+    int synonyms = pick(synonymCounts, rng);
+    for (int i = 0, tries = 0; i < synonyms && !live.empty() && tries < 32; tries++) {
+        const GeneratedWord& candidate = pick(live, rng);
+        if (candidate.category == entry.category && candidate.word != entry.word &&
+            find(entry.synonyms, entry.synonyms + i, candidate.word) == entry.synonyms + i) {
+            entry.synonyms[i++] = candidate.word;
+        }
+    }
+}
+
+void writeEntry(ostream& out, const GeneratedWord& entry) {
+    out << entry.word << '\t' << entry.meaning << '\t' << entry.category;
+    for (const string& synonym : entry.synonyms) {
+        out << '\t' << synonym;
+    }
+    out << '\n';
+}
+
+void writeTrace(ostream& out, const GeneratorConfig& config, vector<GeneratedWord>& live,
+                unordered_set<string>& used, const vector<string>& vocabulary, mt19937_64& rng) {
+    ZipfSampler vocabularySampler(vocabulary.size(), config.zipf);
+    ZipfSampler reads(live.size(), config.zipf);
+    // Popularity is independent of alphabetical order: popularity[rank] is an index
+    // into live, and rankOf maps it back so deletes and inserts keep a permutation.
+    vector<size_t> popularity(live.size());
+    for (size_t i = 0; i < popularity.size(); i++) {
+        popularity[i] = i;
+    }
+    shuffle(popularity.begin(), popularity.end(), rng);
+    vector<size_t> rankOf(live.size());
+    for (size_t rank = 0; rank < popularity.size(); rank++) {
+        rankOf[popularity[rank]] = rank;
+    }
+    auto swapRanks = [&popularity, &rankOf](size_t a, size_t b) {
+        swap(popularity[a], popularity[b]);
+        rankOf[popularity[a]] = a;
+        rankOf[popularity[b]] = b;
+    };
+
+    uniform_real_distribution<double> coin(0.0, 1.0);
+    size_t burstLeft = 0;
+    size_t op = 0;
+    while (op < config.ops) {
+        if (burstLeft > 0) {
+            GeneratedWord fresh = generateWords(1, used, rng)[0];
+            fillMeaning(fresh, vocabulary, vocabularySampler, rng);
+            pickLiveSynonyms(fresh, live, rng);
+            out << "add\t";
+            writeEntry(out, fresh);
+            live.push_back(move(fresh));
+            // A new word takes a random rank; the word it displaces becomes the least popular.
+            popularity.push_back(live.size() - 1);
+            rankOf.push_back(popularity.size() - 1);
+            swapRanks(uniform_int_distribution<size_t>(0, popularity.size() - 1)(rng), popularity.size() - 1);
+            // Resize the read skew once the dictionary has grown or shrunk well past it.
+            if (live.size() > reads.size() + reads.size() / 4) {
+                reads = ZipfSampler(live.size(), config.zipf);
+            }
+            burstLeft--;
+            op++;
+            continue;
+        }
+
+        double u = coin(rng);
+        if (u < config.readRatio && !live.empty()) {
+            size_t rank = reads(rng);
+            while (rank >= popularity.size()) {
+                rank = reads(rng);
+            }
+            out << "show\t" << live[popularity[rank]].word << '\n';
+        } else if ((u -= config.readRatio) < config.insertRatio) {
+            // Bursts average (burst + 1) / 2 inserts, so start them proportionally less often
+            // to keep inserts at roughly insertRatio of all operations.
+            double burstMean = (max<size_t>(config.burst, 1) + 1) / 2.0;
+            if (coin(rng) * burstMean < 1.0) {
+                burstLeft = uniform_int_distribution<size_t>(1, max<size_t>(config.burst, 1))(rng);
+            }
+            // Deciding on a burst writes nothing; the burst's adds are the operations, so draw again.
+            continue;
+        } else if ((u -= config.insertRatio) < config.deleteRatio && !live.empty()) {
+            size_t index = uniform_int_distribution<size_t>(0, live.size() - 1)(rng);
+            out << "delete\t" << live[index].word << '\n';
+            // Drop the deleted word's rank, then move the last word into its slot of live.
+            size_t last = live.size() - 1;
+            swapRanks(rankOf[index], popularity.size() - 1);
+            popularity.pop_back();
+            if (index != last) {
+                live[index] = move(live[last]);
+                rankOf[index] = rankOf[last];
+                popularity[rankOf[index]] = index;
+            }
+            live.pop_back();
+            rankOf.pop_back();
+            if (live.size() * 2 < reads.size()) {
+                reads = ZipfSampler(live.size(), config.zipf);
+            }
+        } else if (!live.empty()) {
+            const GeneratedWord& target = pick(live, rng);
+            switch (uniform_int_distribution<int>(0, 9)(rng)) {
+                case 0:
+                    out << "category\t" << target.category << '\n';
+                    break;
+                case 1:
+                    out << "letter\t" << target.word[0] << '\n';
+                    break;
+                case 2:
+                    out << "count\n";
+                    break;
+                default:
+                    out << "modify\t" << target.word << "\tmeaning\t" << target.meaning << " (revisado)\n";
+            }
+        }
+        op++;
+    }
+}
+
+int main(int argc, char** argv) {
+    GeneratorConfig config;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        string value = argv[i + 1];
+        if (flag == "--words") {
+            config.words = stoull(value);
+        } else if (flag == "--seed") {
+            config.seed = (unsigned) stoul(value);
+        } else if (flag == "--dict") {
+            config.dictPath = value;
+        } else if (flag == "--trace") {
+            config.tracePath = value;
+        } else if (flag == "--ops") {
+            config.ops = stoull(value);
+        } else if (flag == "--zipf") {
+            config.zipf = stod(value);
+        } else if (flag == "--read-ratio") {
+            config.readRatio = stod(value);
+        } else if (flag == "--insert-ratio") {
+            config.insertRatio = stod(value);
+        } else if (flag == "--delete-ratio") {
+            config.deleteRatio = stod(value);
+        } else if (flag == "--burst") {
+            config.burst = stoull(value);
+        } else {
+            cerr << "Unknown option: " << flag << "\n";
+            return 1;
+        }
+    }
+
+    mt19937_64 rng(config.seed);
+    unordered_set<string> used;
+    vector<GeneratedWord> words = generateWords(config.words, used, rng);
+    vector<string> vocabulary = buildVocabulary(words);
+    fillMeaningsAndSynonyms(words, vocabulary, config.zipf, rng);
+
+    ofstream dict(config.dictPath);
+    if (!dict) {
+        cerr << "Cannot open " << config.dictPath << "\n";
+        return 1;
+    }
+    for (const GeneratedWord& entry : words) {
+        writeEntry(dict, entry);
+    }
+
+    if (!config.tracePath.empty()) {
+        ofstream trace(config.tracePath);
+        if (!trace) {
+            cerr << "Cannot open " << config.tracePath << "\n";
+            return 1;
+        }
+        writeTrace(trace, config, words, used, vocabulary, rng);
+    }
+    return 0;
+}
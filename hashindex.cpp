@@ -0,0 +1,184 @@
+#include "hashindex.h"
+
+#include <bit>
+#include <strings.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "dictionary.h"
+
+using namespace std;
+
+static const size_t groupSize = 16;
+static const uint8_t emptySlot = 0x80;
+static const uint8_t deletedSlot = 0xFE;
+
+// Bit i is set when control byte i of the group equals value.
+static uint32_t matchGroup(const uint8_t* group, uint8_t value) {
+#if defined(__SSE2__)
+    __m128i bytes = _mm_loadu_si128((const __m128i*) group);
+    return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char) value)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < groupSize; i++) {
+        mask |= (uint32_t) (group[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+// The low seven bits tag the slot; the rest choose the first group.
+static uint8_t tagOf(uint64_t hash) {
+    return (uint8_t) (hash & 0x7F);
+}
+
+static size_t groupCount(const HashIndex* index) {
+    return index->control.size() / groupSize;
+}
+
+// Triangular steps visit every group when the group count is a power of two.
+static size_t nextGroup(const HashIndex* index, size_t group, size_t step) {
+    return (group + step) & (groupCount(index) - 1);
+}
+
+// Slot holding word, or SIZE_MAX; groups counts the groups looked at.
+static size_t findSlot(const HashIndex* index, const string& word, uint64_t& groups) {
+    uint64_t hash = hashWord(word);
+    uint8_t tag = tagOf(hash);
+    size_t group = (hash >> 7) & (groupCount(index) - 1);
+    for (size_t step = 1; step <= groupCount(index); step++) {
+        const uint8_t* control = &index->control[group * groupSize];
+        groups++;
+        for (uint32_t mask = matchGroup(control, tag); mask != 0; mask &= mask - 1) {
+            size_t slot = group * groupSize + countr_zero(mask);
+            if (strcasecmp(index->nodes[slot]->word.c_str(), word.c_str()) == 0) {
+                return slot;
+            }
+        }
+        if (matchGroup(control, emptySlot) != 0) {
+            break;
+        }
+        group = nextGroup(index, group, step);
+    }
+    return SIZE_MAX;
+}
+
+// Places node in the first empty or deleted slot of its probe sequence.
+static void placeNode(HashIndex* index, Node* node) {
+    uint64_t hash = hashWord(node->word);
+    size_t group = (hash >> 7) & (groupCount(index) - 1);
+    for (size_t step = 1;; step++) {
+        uint8_t* control = &index->control[group * groupSize];
+        uint32_t available = matchGroup(control, emptySlot) | matchGroup(control, deletedSlot);
+        if (available != 0) {
+            size_t slot = group * groupSize + countr_zero(available);
+            if (index->control[slot] == deletedSlot) {
+                index->deleted--;
+            }
+            index->control[slot] = tagOf(hash);
+            index->nodes[slot] = node;
+            index->size++;
+            return;
+        }
+        group = nextGroup(index, group, step);
+    }
+}
+
+// Sized so the entries fill at most half of the slots.
+static void resizeIndex(HashIndex* index, size_t entries) {
+    size_t groups = 1;
+    while (groups * groupSize < entries * 2) {
+        groups *= 2;
+    }
+    index->control.assign(groups * groupSize, emptySlot);
+    index->nodes.assign(groups * groupSize, nullptr);
+    index->size = 0;
+    index->deleted = 0;
+}
+
+void hashIndexInsert(HashIndex* index, Node* node) {
+    // Deleted slots lengthen probes as much as live ones; rehash at 7/8 occupancy.
+    if ((index->size + index->deleted + 1) * 8 > index->control.size() * 7) {
+        vector<Node*> live;
+        live.reserve(index->size);
+        for (size_t slot = 0; slot < index->control.size(); slot++) {
+            if (index->control[slot] < emptySlot) {
+                live.push_back(index->nodes[slot]);
+            }
+        }
+        resizeIndex(index, live.size() + 1);
+        for (Node* entry : live) {
+            placeNode(index, entry);
+        }
+    }
+    placeNode(index, node);
+}
+
+Node* hashIndexFind(HashIndex* index, const string& word) {
+    index->lookups++;
+    size_t slot = findSlot(index, word, index->groupsProbed);
+    return slot == SIZE_MAX ? nullptr : index->nodes[slot];
+}
+
+void hashIndexErase(HashIndex* index, const string& word) {
+    uint64_t groups = 0;
+    size_t slot = findSlot(index, word, groups);
+    if (slot == SIZE_MAX) {
+        return;
+    }
+    // A group that still has an empty slot never let a probe continue past it,
+    // so the slot can become empty again instead of a tombstone.
+    size_t group = slot / groupSize;
+    if (matchGroup(&index->control[group * groupSize], emptySlot) != 0) {
+        index->control[slot] = emptySlot;
+    } else {
+        index->control[slot] = deletedSlot;
+        index->deleted++;
+    }
+    index->nodes[slot] = nullptr;
+    index->size--;
+}
+
+void hashIndexRepoint(HashIndex* index, const string& word, Node* node) {
+    uint64_t groups = 0;
+    size_t slot = findSlot(index, word, groups);
+    if (slot != SIZE_MAX) {
+        index->nodes[slot] = node;
+    }
+}
+
+void rebuildHashIndex(Dictionary* dictionary) {
+    HashIndex* index = dictionary->index;
+    vector<Node*> nodes;
+    flattenLiveTree(dictionary->root, nodes);
+    resizeIndex(index, nodes.size());
+    for (Node* node : nodes) {
+        placeNode(index, node);
+    }
+}
+
+void enableHashIndex(Dictionary* dictionary) {
+    if (dictionary->index == nullptr) {
+        dictionary->index = new HashIndex();
+    }
+    rebuildHashIndex(dictionary);
+}
+
+void disableHashIndex(Dictionary* dictionary) {
+    delete dictionary->index;
+    dictionary->index = nullptr;
+}
+
+void printHashIndexStats(const Dictionary* dictionary, ostream& out) {
+    const HashIndex* index = dictionary->index;
+    if (index == nullptr) {
+        out << "Hash index is disabled.\n";
+        return;
+    }
+    out << "Hash index: " << index->size << " words in " << index->control.size() << " slots, "
+        << index->deleted << " deleted slots\n";
+    out << "Lookups: " << index->lookups << ", groups probed per lookup: "
+        << (index->lookups == 0 ? 0.0 : (double) index->groupsProbed / index->lookups) << "\n";
+}
@@ -0,0 +1,42 @@
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct Dictionary;
+struct Node;
+
+/*
+Open-addressing hash index from the lowercased word to its tree node, in the style
+of a Swiss table. Slots are grouped sixteen at a time and every slot has a control
+byte: empty, deleted, or seven bits of the word's hash. A probe compares the control
+bytes of a whole group against those seven bits in one SSE2 instruction and only
+compares words for the few slots that match; an empty slot in the group ends the
+search. searchWord(Dictionary*, ...) answers from the index in O(1) while the tree
+keeps serving ordered queries. addWord and deleteWord keep it in sync, and it is
+rebuilt from the tree after bulk loads.
+*/
+struct HashIndex {
+    std::vector<uint8_t> control;
+    std::vector<Node*> nodes;
+    size_t size;
+    size_t deleted;
+    uint64_t lookups;
+    uint64_t groupsProbed;
+};
+
+void enableHashIndex(Dictionary* dictionary);
+void disableHashIndex(Dictionary* dictionary);
+void rebuildHashIndex(Dictionary* dictionary);
+Node* hashIndexFind(HashIndex* index, const std::string& word);
+// node->word must not be in the index yet.
+void hashIndexInsert(HashIndex* index, Node* node);
+void hashIndexErase(HashIndex* index, const std::string& word);
+// Points word's slot at node, for when a delete moves an entry into another node.
+void hashIndexRepoint(HashIndex* index, const std::string& word, Node* node);
+void printHashIndexStats(const Dictionary* dictionary, std::ostream& out);
+
+#endif
@@ -0,0 +1,74 @@
+#include "hotcache.h"
+
+#include <strings.h>
+
+#include "dictionary.h"
+
+using namespace std;
+
+static const uint8_t maxFrequency = 15;
+
+static HotSlot& slotFor(HotCache* cache, const string& word) {
+    return cache->slots[hashWord(word) & (cache->slots.size() - 1)];
+}
+
+// The slot count is rounded up to a power of two.
+void enableHotCache(Dictionary* dictionary, size_t slots) {
+    size_t size = 1;
+    while (size < slots) {
+        size *= 2;
+    }
+    delete dictionary->hotCache;
+    dictionary->hotCache = new HotCache{vector<HotSlot>(size, HotSlot{nullptr, 0}), 0, 0};
+}
+
+void disableHotCache(Dictionary* dictionary) {
+    delete dictionary->hotCache;
+    dictionary->hotCache = nullptr;
+}
+
+Node* hotCacheFind(HotCache* cache, const string& word) {
+    HotSlot& slot = slotFor(cache, word);
+    if (slot.node != nullptr && strcasecmp(slot.node->word.c_str(), word.c_str()) == 0) {
+        if (slot.frequency < maxFrequency) {
+            slot.frequency++;
+        }
+        cache->hits++;
+        return slot.node;
+    }
+    cache->misses++;
+    return nullptr;
+}
+
+void hotCacheOffer(HotCache* cache, const string& word, Node* node) {
+    HotSlot& slot = slotFor(cache, word);
+    if (slot.node == nullptr || slot.frequency == 0) {
+        slot.node = node;
+        slot.frequency = 1;
+    } else {
+        slot.frequency--;
+    }
+}
+
+// Must be called for every word whose node is about to be freed or overwritten.
+void hotCacheForget(HotCache* cache, const string& word) {
+    HotSlot& slot = slotFor(cache, word);
+    if (slot.node != nullptr && strcasecmp(slot.node->word.c_str(), word.c_str()) == 0) {
+        slot.node = nullptr;
+        slot.frequency = 0;
+    }
+}
+
+void printHotCacheStats(const Dictionary* dictionary, ostream& out) {
+    const HotCache* cache = dictionary->hotCache;
+    if (cache == nullptr) {
+        out << "Hot cache is disabled.\n";
+        return;
+    }
+    size_t used = 0;
+    for (const HotSlot& slot : cache->slots) {
+        used += slot.node != nullptr;
+    }
+    out << "Hot cache: " << used << " of " << cache->slots.size() << " slots used\n";
+    out << "Hits: " << cache->hits << ", misses: " << cache->misses << "\n";
+}
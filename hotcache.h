@@ -0,0 +1,38 @@
+#ifndef HOTCACHE_H
+#define HOTCACHE_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct Dictionary;
+struct Node;
+
+/*
+Direct-mapped cache of recently found nodes keyed by the lowercased word, checked
+by searchWord(Dictionary*, ...) before the tree descent. Each slot keeps a small
+frequency counter: hits raise it, and a miss that maps to an occupied slot lowers it
+and only takes the slot over once it reaches zero. Frequently read words therefore
+stay cached under Zipf-skewed traffic, while a miss never costs more than one hash
+and one string comparison on top of the normal descent.
+*/
+struct HotSlot {
+    Node* node;
+    uint8_t frequency;
+};
+
+struct HotCache {
+    std::vector<HotSlot> slots;
+    uint64_t hits;
+    uint64_t misses;
+};
+
+void enableHotCache(Dictionary* dictionary, size_t slots);
+void disableHotCache(Dictionary* dictionary);
+Node* hotCacheFind(HotCache* cache, const std::string& word);
+void hotCacheOffer(HotCache* cache, const std::string& word, Node* node);
+void hotCacheForget(HotCache* cache, const std::string& word);
+void printHotCacheStats(const Dictionary* dictionary, std::ostream& out);
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef ITERATOR_H
+#define ITERATOR_H
+
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <string>
+#include <strings.h>
+#include <vector>
+
+#include "dictionary.h"
+
+/*
+Lazy in-order traversal of the tree as a bidirectional iterator. Nodes have no
+parent links, so the iterator keeps the path from the root to the current node;
+an empty path is end(). Each step is amortized O(1) and nothing is materialized,
+so ranges pipelines (filter, take, reverse...) stop as soon as the consumer does.
+Tombstones are stepped over, so only live words are visited.
+The iterator is invalidated by any insertion or deletion in the tree.
+*/
+class DictionaryIterator {
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using iterator_concept = std::bidirectional_iterator_tag;
+    using value_type = Node;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Node*;
+    using reference = Node&;
+
+    DictionaryIterator() : root(nullptr) {}
+    // A path ending at a tombstone moves on to the next live word.
+    DictionaryIterator(Node* root, std::vector<Node*> path) : root(root), path(std::move(path)) {
+        while (!this->path.empty() && this->path.back()->tombstone) {
+            advance();
+        }
+    }
+
+    Node& operator*() const { return *path.back(); }
+    Node* operator->() const { return path.back(); }
+
+    // Number of nodes on the search path of the current node.
+    int depth() const { return (int) path.size(); }
+
+    DictionaryIterator& operator++() {
+        do {
+            advance();
+        } while (!path.empty() && path.back()->tombstone);
+        return *this;
+    }
+
+    DictionaryIterator operator++(int) {
+        DictionaryIterator previous = *this;
+        ++*this;
+        return previous;
+    }
+
+    // Decrementing end() moves to the last word.
+    DictionaryIterator& operator--() {
+        do {
+            retreat();
+        } while (!path.empty() && path.back()->tombstone);
+        return *this;
+    }
+
+    DictionaryIterator operator--(int) {
+        DictionaryIterator previous = *this;
+        --*this;
+        return previous;
+    }
+
+    bool operator==(const DictionaryIterator& other) const {
+        if (path.empty() || other.path.empty()) {
+            return path.empty() && other.path.empty();
+        }
+        return path.back() == other.path.back();
+    }
+
+private:
+    Node* root;
+    std::vector<Node*> path;
+
+    void advance() {
+        Node* current = path.back();
+        if (current->right != nullptr) {
+            descend(current->right, false);
+        } else {
+            climb(false);
+        }
+    }
+
+    void retreat() {
+        if (path.empty()) {
+            descend(root, true);
+        } else if (path.back()->left != nullptr) {
+            descend(path.back()->left, true);
+        } else {
+            climb(true);
+        }
+    }
+
+    // Pushes node and then keeps going left (or right when rightmost is set).
+    void descend(Node* node, bool rightmost) {
+        while (node != nullptr) {
+            path.push_back(node);
+            node = rightmost ? node->right : node->left;
+        }
+    }
+
+    // Pops until the current node is reached from a left (or right) child.
+    void climb(bool fromLeft) {
+        Node* child = path.back();
+        path.pop_back();
+        while (!path.empty() && (fromLeft ? path.back()->left : path.back()->right) == child) {
+            child = path.back();
+            path.pop_back();
+        }
+    }
+};
+
+class DictionaryView : public std::ranges::view_interface<DictionaryView> {
+public:
+    DictionaryView() : root(nullptr) {}
+    explicit DictionaryView(Node* root) : root(root) {}
+
+    DictionaryIterator begin() const {
+        std::vector<Node*> path;
+        for (Node* node = root; node != nullptr; node = node->left) {
+            path.push_back(node);
+        }
+        return DictionaryIterator(root, std::move(path));
+    }
+
+    DictionaryIterator end() const { return DictionaryIterator(root, {}); }
+
+    // First word not alphabetically before word (ignoring case), or end().
+    DictionaryIterator lower_bound(const std::string& word) const { return bound(word, false); }
+
+    // First word alphabetically after word (ignoring case), or end().
+    DictionaryIterator upper_bound(const std::string& word) const { return bound(word, true); }
+
+    DictionaryIterator find(const std::string& word) const {
+        DictionaryIterator found = lower_bound(word);
+        if (found != end() && strcasecmp(found->word.c_str(), word.c_str()) == 0) {
+            return found;
+        }
+        return end();
+    }
+
+private:
+    Node* root;
+
+    // The answer is the last node where the descent turned left; the path is cut there.
+    DictionaryIterator bound(const std::string& word, bool strict) const {
+        std::vector<Node*> path;
+        size_t answer = 0;
+        for (Node* node = root; node != nullptr;) {
+            path.push_back(node);
+            int order = strcasecmp(word.c_str(), node->word.c_str());
+            if (order < 0 || (order == 0 && !strict)) {
+                answer = path.size();
+                node = node->left;
+            } else {
+                node = node->right;
+            }
+        }
+        path.resize(answer);
+        return DictionaryIterator(root, std::move(path));
+    }
+};
+
+inline DictionaryView dictionaryView(Node* root) {
+    return DictionaryView(root);
+}
+
+inline DictionaryView dictionaryView(const Dictionary* dictionary) {
+    return DictionaryView(dictionary->root);
+}
+
+static_assert(std::bidirectional_iterator<DictionaryIterator>);
+static_assert(std::ranges::bidirectional_range<DictionaryView>);
+static_assert(std::ranges::view<DictionaryView>);
+
+#endif
@@ -0,0 +1,135 @@
+#include "latency.h"
+
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+
+static const int linearBuckets = 128;
+static const int subBuckets = 64;
+static const int maxExponent = 40;
+static const int bucketCount = linearBuckets + (maxExponent - 6) * subBuckets;
+
+static const char* operationNames[LAT_OPERATIONS] = {
+    "add", "modify", "show", "search", "delete", "list_category", "list_letter", "list_all",
+    "first_last", "count"};
+
+static int bucketIndex(uint64_t value) {
+    if (value < linearBuckets) {
+        return (int) value;
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent >= maxExponent) {
+        return bucketCount - 1;
+    }
+    int shift = exponent - 6;
+    return linearBuckets + (shift - 1) * subBuckets + (int) ((value >> shift) - subBuckets);
+}
+
+// Highest value that falls into the bucket, so percentiles never under-report.
+static uint64_t bucketValue(int index) {
+    if (index < linearBuckets) {
+        return (uint64_t) index;
+    }
+    int shift = (index - linearBuckets) / subBuckets + 1;
+    uint64_t top = (uint64_t) ((index - linearBuckets) % subBuckets + subBuckets);
+    return ((top + 1) << shift) - 1;
+}
+
+LatencyHistogram::LatencyHistogram() : buckets(bucketCount, 0) {}
+
+void LatencyHistogram::record(uint64_t nanoseconds) {
+    buckets[bucketIndex(nanoseconds)]++;
+    count++;
+    if (nanoseconds > max) {
+        max = nanoseconds;
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < bucketCount; i++) {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    if (other.max > max) {
+        max = other.max;
+    }
+}
+
+uint64_t LatencyHistogram::percentile(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = (uint64_t) (quantile * count);
+    if (rank >= count) {
+        rank = count - 1;
+    }
+    uint64_t seen = 0;
+    for (int i = 0; i < bucketCount; i++) {
+        seen += buckets[i];
+        if (seen > rank) {
+            return bucketValue(i) < max ? bucketValue(i) : max;
+        }
+    }
+    return max;
+}
+
+// Written only by the owning thread; relaxed atomics let other threads merge concurrently.
+struct ThreadLatencies {
+    atomic<uint64_t> buckets[LAT_OPERATIONS][bucketCount];
+    atomic<uint64_t> max[LAT_OPERATIONS];
+};
+
+// Thread slots are never freed so samples from finished threads stay in the report.
+static mutex registryMutex;
+static vector<ThreadLatencies*> registry;
+
+static ThreadLatencies* threadLatencies() {
+    thread_local ThreadLatencies* mine = nullptr;
+    if (mine == nullptr) {
+        mine = new ThreadLatencies();
+        lock_guard<mutex> lock(registryMutex);
+        registry.push_back(mine);
+    }
+    return mine;
+}
+
+void recordLatency(LatencyOperation operation, uint64_t nanoseconds) {
+    ThreadLatencies* mine = threadLatencies();
+    atomic<uint64_t>& bucket = mine->buckets[operation][bucketIndex(nanoseconds)];
+    bucket.store(bucket.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    if (nanoseconds > mine->max[operation].load(memory_order_relaxed)) {
+        mine->max[operation].store(nanoseconds, memory_order_relaxed);
+    }
+}
+
+vector<LatencyHistogram> mergeLatencies() {
+    vector<LatencyHistogram> merged(LAT_OPERATIONS);
+    lock_guard<mutex> lock(registryMutex);
+    for (ThreadLatencies* thread : registry) {
+        for (int op = 0; op < LAT_OPERATIONS; op++) {
+            LatencyHistogram histogram;
+            for (int i = 0; i < bucketCount; i++) {
+                histogram.buckets[i] = thread->buckets[op][i].load(memory_order_relaxed);
+                histogram.count += histogram.buckets[i];
+            }
+            histogram.max = thread->max[op].load(memory_order_relaxed);
+            merged[op].merge(histogram);
+        }
+    }
+    return merged;
+}
+
+void printLatencyReport(ostream& out) {
+    vector<LatencyHistogram> merged = mergeLatencies();
+    out << "operation,count,p50_ns,p90_ns,p99_ns,p99.9_ns,max_ns\n";
+    for (int op = 0; op < LAT_OPERATIONS; op++) {
+        const LatencyHistogram& histogram = merged[op];
+        if (histogram.count == 0) {
+            continue;
+        }
+        out << operationNames[op] << ',' << histogram.count << ',' << histogram.percentile(0.50) << ','
+            << histogram.percentile(0.90) << ',' << histogram.percentile(0.99) << ','
+            << histogram.percentile(0.999) << ',' << histogram.max << '\n';
+    }
+}
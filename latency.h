@@ -0,0 +1,60 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/*
+Per-operation latency histograms in the HDR style: values up to 127 ns get one
+bucket each, larger values are split into 64 linear sub-buckets per power of two,
+so every recorded value is kept to within 1.6%. Each thread records into its own
+histograms without locks; mergeLatencies sums all threads for reporting.
+*/
+
+enum LatencyOperation {
+    LAT_ADD,
+    LAT_MODIFY,
+    LAT_SHOW,
+    LAT_SEARCH,
+    LAT_DELETE,
+    LAT_LIST_CATEGORY,
+    LAT_LIST_LETTER,
+    LAT_LIST_ALL,
+    LAT_FIRST_LAST,
+    LAT_COUNT,
+    LAT_OPERATIONS
+};
+
+struct LatencyHistogram {
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    uint64_t max = 0;
+
+    LatencyHistogram();
+    void record(uint64_t nanoseconds);
+    void merge(const LatencyHistogram& other);
+    uint64_t percentile(double quantile) const;
+};
+
+void recordLatency(LatencyOperation operation, uint64_t nanoseconds);
+std::vector<LatencyHistogram> mergeLatencies();
+void printLatencyReport(std::ostream& out);
+
+class LatencyTimer {
+public:
+    explicit LatencyTimer(LatencyOperation operation)
+        : operation(operation), start(std::chrono::steady_clock::now()) {}
+
+    ~LatencyTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        recordLatency(operation, (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+private:
+    LatencyOperation operation;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
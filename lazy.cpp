@@ -0,0 +1,146 @@
+#include "lazy.h"
+
+#include <filesystem>
+#include <vector>
+
+using namespace std;
+
+static void dropFields(Node* node) {
+    string().swap(node->meaning);
+    for (string& synonym : node->synonyms) {
+        string().swap(synonym);
+    }
+}
+
+int loadDictionaryLazy(Dictionary* dictionary, const string& path, size_t cacheCapacity) {
+    // Nodes already read from the first file would look up their offsets in the second.
+    if (dictionary->lazy != nullptr) {
+        return -1;
+    }
+    LazyStore* opened = new LazyStore();
+    opened->path = path;
+    opened->file.open(path, ios::binary);
+    if (!opened->file) {
+        delete opened;
+        return -1;
+    }
+    opened->capacity = cacheCapacity > 0 ? cacheCapacity : 1;
+
+    vector<Node*> nodes;
+    string line;
+    long long offset = 0;
+    string noSynonyms[3];
+    while (getline(opened->file, line)) {
+        long long lineOffset = offset;
+        offset += (long long) line.size() + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        vector<string> fields = splitFields(line, '\t');
+        fields.resize(3);
+        Node* node = createNode(move(fields[0]), "", move(fields[2]), noSynonyms);
+        node->offset = lineOffset;
+        nodes.push_back(node);
+    }
+    opened->file.clear();
+
+    dictionary->lazy = opened;
+    return linkLoadedNodes(dictionary, nodes);
+}
+
+// The entry's line split into its six fields.
+static vector<string> readFields(LazyStore* store, long long offset) {
+    string line;
+    store->file.seekg(offset);
+    getline(store->file, line);
+    store->file.clear();
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    vector<string> fields = splitFields(line, '\t');
+    fields.resize(6);
+    return fields;
+}
+
+void materializeEntry(LazyStore* store, Node* node) {
+    if (store == nullptr || node->offset < 0) {
+        return;
+    }
+    auto found = store->resident.find(node);
+    if (found != store->resident.end()) {
+        store->recent.splice(store->recent.begin(), store->recent, found->second);
+        store->hits++;
+        return;
+    }
+    store->misses++;
+
+    vector<string> fields = readFields(store, node->offset);
+    node->meaning = fields[1];
+    for (int i = 0; i < 3; i++) {
+        node->synonyms[i] = fields[3 + i];
+    }
+
+    store->recent.push_front(node);
+    store->resident[node] = store->recent.begin();
+    if (store->recent.size() > store->capacity) {
+        Node* evicted = store->recent.back();
+        store->recent.pop_back();
+        store->resident.erase(evicted);
+        dropFields(evicted);
+    }
+}
+
+WordEntry readEntry(LazyStore* store, Node* node) {
+    WordEntry entry{node->word, node->meaning, node->grammaticalCategory,
+                    {node->synonyms[0], node->synonyms[1], node->synonyms[2]}};
+    if (store == nullptr || node->offset < 0 || store->resident.count(node) > 0) {
+        return entry;
+    }
+    vector<string> fields = readFields(store, node->offset);
+    entry.meaning = move(fields[1]);
+    for (int i = 0; i < 3; i++) {
+        entry.synonyms[i] = move(fields[3 + i]);
+    }
+    return entry;
+}
+
+// Loads the entry and detaches it from the file for good, e.g. before it is modified.
+void pinEntry(LazyStore* store, Node* node) {
+    materializeEntry(store, node);
+    forgetEntry(store, node);
+    node->offset = -1;
+}
+
+// Must be called before a node is freed or its payload is overwritten.
+void forgetEntry(LazyStore* store, Node* node) {
+    if (store == nullptr) {
+        return;
+    }
+    auto found = store->resident.find(node);
+    if (found != store->resident.end()) {
+        store->recent.erase(found->second);
+        store->resident.erase(found);
+    }
+}
+
+bool isLazySource(const Dictionary* dictionary, const string& path) {
+    const LazyStore* store = dictionary->lazy;
+    if (store == nullptr) {
+        return false;
+    }
+    error_code error;
+    return filesystem::equivalent(store->path, path, error);
+}
+
+void printLazyStats(const Dictionary* dictionary, ostream& out) {
+    const LazyStore* store = dictionary->lazy;
+    if (store == nullptr) {
+        out << "Lazy loading is not active.\n";
+        return;
+    }
+    out << "Resident entries: " << store->recent.size() << " of " << store->capacity << "\n";
+    out << "Cache hits: " << store->hits << ", misses: " << store->misses << "\n";
+}
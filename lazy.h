@@ -0,0 +1,43 @@
+#ifndef LAZY_H
+#define LAZY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "dictionary.h"
+
+/*
+Lazy loading mode: only the word, grammatical category and the entry's file offset
+are kept in memory. Meaning and synonyms are read back from the dictionary file the
+first time an entry is shown and kept in a bounded LRU cache; evicted entries drop
+their strings again. The file must stay unchanged while the dictionary is in use.
+The store belongs to the Dictionary (dictionary->lazy), and every function that
+reads or frees nodes takes it; it is null when every entry is resident. Only one
+file can be loaded lazily per dictionary; a second load fails.
+*/
+struct LazyStore {
+    std::string path;
+    std::ifstream file;
+    size_t capacity;
+    std::list<Node*> recent;
+    std::unordered_map<Node*, std::list<Node*>::iterator> resident;
+    uint64_t hits;
+    uint64_t misses;
+};
+
+int loadDictionaryLazy(Dictionary* dictionary, const std::string& path, size_t cacheCapacity);
+void materializeEntry(LazyStore* store, Node* node);
+// Copies the entry; one that is not resident is read from the file without caching it.
+WordEntry readEntry(LazyStore* store, Node* node);
+void pinEntry(LazyStore* store, Node* node);
+void forgetEntry(LazyStore* store, Node* node);
+// True if path names the file lazy entries are read from, which must not be overwritten.
+bool isLazySource(const Dictionary* dictionary, const std::string& path);
+void printLazyStats(const Dictionary* dictionary, std::ostream& out);
+
+#endif
@@ -39,67 +39,31 @@ Implementation Considerations:
     User Input Validation: Implement checks to ensure the accuracy and integrity of data entered by the user.
  */
 
+#include <cstdint>
+#include <fstream>
 #include <iostream>
-#include <strings.h>
 
-using namespace std;
-
-struct Node {
-    string word;
-    string meaning;
-    string grammaticalCategory;
-    string synonyms[3];
-    Node* left;
-    Node* right;
-};
-
-struct Dictionary {
-    Node* root;
-};
-
-Node* createNode(string word, string meaning, string grammaticalCategory, string synonyms[3]) {
-    Node* newNode = new Node();
-    newNode->word = word;
-    newNode->meaning = meaning;
-    newNode->grammaticalCategory = grammaticalCategory;
-    for (int i = 0; i < 3; i++) {
-        newNode->synonyms[i] = synonyms[i];
-    }
-    newNode->left = nullptr;
-    newNode->right = nullptr;
-    return newNode;
-}
+#include "batch.h"
+#include "checkpoint.h"
+#include "bloom.h"
+#include "diagnostics.h"
+#include "frozenview.h"
+#include "hashindex.h"
+#include "hotcache.h"
+#include "dictionary.h"
+#include "latency.h"
+#include "lazy.h"
+#include "memory.h"
+#include "paging.h"
+#include "parallel.h"
+#include "scapegoat.h"
+#include "tombstone.h"
+#include "stats.h"
+#include "trace.h"
 
-void insertNode(Node* root, Node* newNode) {
-    if (strcasecmp(newNode->word.c_str(), root->word.c_str()) < 0) {
-        if (root->left == nullptr) {
-            root->left = newNode;
-        } else {
-            insertNode(root->left, newNode);
-        }
-    } else {
-        if(strcasecmp(newNode->word.c_str(), root->word.c_str()) == 0) {
-            cout << "Word already exists in the dictionary.\n";
-            return;
-        }
-        if (root->right == nullptr) {
-            root->right = newNode;
-        } else {
-            insertNode(root->right, newNode);
-        }
-    }
-}
-
-void addWord(Dictionary* dictionary, string word, string meaning, string grammaticalCategory, string synonyms[3]) {
-    Node* newNode = createNode(word, meaning, grammaticalCategory, synonyms);
-    if (dictionary->root == nullptr) {
-        dictionary->root = newNode;
-    } else {
-        insertNode(dictionary->root, newNode);
-    }
-}
+using namespace std;
 
-void addWordMenu(Dictionary* dictionary) {
+void addWordMenu(Dictionary* dictionary, TraceRecorder* recorder) {
     string word, meaning, grammaticalCategory, synonyms[3];
     cout << "Enter the word: ";
     cin >> word;
@@ -111,235 +75,465 @@ void addWordMenu(Dictionary* dictionary) {
     for (int i = 0; i < 3; i++) {
         cin >> synonyms[i];
     }
-    addWord(dictionary, word, meaning, grammaticalCategory, synonyms);
-    cout << "Word added successfully!\n";
+    bool added;
+    {
+        LatencyTimer timer(LAT_ADD);
+        added = addWord(dictionary, word, meaning, grammaticalCategory, synonyms);
+    }
+    recordOperation(recorder, {"add", word, meaning, grammaticalCategory, synonyms[0], synonyms[1], synonyms[2]});
+    if (added) {
+        cout << "Word added successfully!\n";
+    }
 }
 
-void modifyWordMenu(Node *word) {
-    cout << "Modify elements of the word \"" << word << "\":\n";
+void modifyWordMenu(Dictionary* dictionary, Node *word, TraceRecorder* recorder) {
+    cout << "Modify elements of the word \"" << word->word << "\":\n";
     cout << "1. Modify meaning\n";
     cout << "2. Modify grammatical category\n";
     cout << "3. Modify synonyms\n";
     cout << "4. Return to main menu\n";
     int choice;
     cin >> choice;
-
     switch (choice) {
         case 1:
             cout << "Enter the new meaning: ";
+            pinEntry(dictionary->lazy, word);
             cin >> word->meaning;
+            recordOperation(recorder, {"modify", word->word, "meaning", word->meaning});
             cout << "Meaning updated successfully!\n";
             break;
         case 2:
             cout << "Enter the new grammatical category: ";
             cin >> word->grammaticalCategory;
+            recordOperation(recorder, {"modify", word->word, "category", word->grammaticalCategory});
             cout << "Grammatical category updated successfully!\n";
             break;
         case 3:
             cout << "Enter up to three new synonyms (separated by spaces): ";
+            pinEntry(dictionary->lazy, word);
             for (int i = 0; i < 3; i++) {
                 cin >> word->synonyms[i];
             }
+            recordOperation(recorder, {"modify", word->word, "synonyms", word->synonyms[0], word->synonyms[1], word->synonyms[2]});
             cout << "Synonyms updated successfully!\n";
             break;
         case 4:
+            recordOperation(recorder, {"search", word->word});
             return;
         default:
+            recordOperation(recorder, {"search", word->word});
             cout << "Invalid choice. Please try again.\n";
     }
+    if (choice >= 1 && choice <= 3) {
+        noteChange(dictionary, word->word, word);
+    }
 }
 
-void showWord(Node* word) {
-    cout << "Word: " << word->word << "\n";
-    cout << "Meaning: " << word->meaning << "\n";
-    cout << "Grammatical Category: " << word->grammaticalCategory << "\n";
-    cout << "Synonyms: ";
-    for (int i = 0; i < 3; i++) {
-        cout << word->synonyms[i] << " ";
-    }
-    cout << "\n";
+void displayMenu() {
+    cout << "Menu:\n";
+    cout << "1. Add word to dictionary\n";
+    cout << "2. Modify elements of a word\n";
+    cout << "3. Show elements of a word\n";
+    cout << "4. Delete word\n";
+    cout << "5. List of words by grammatical category\n";
+    cout << "6. List of words by letter\n";
+    cout << "7. General list of words in alphabetical order\n";
+    cout << "8. Show the first and last word of the dictionary with their components\n";
+    cout << "9. Show the number of words registered in the dictionary\n";
+    cout << "10. Exit\n";
+    cout << "11. Show statistics\n";
+    cout << "12. Show latency percentiles\n";
+    cout << "13. Show tree diagnostics\n";
+    cout << "14. Show memory usage\n";
 }
 
-void deleteWord(Node* root, string word) {
-    if (root == nullptr) {
-        cout << "Word not found.\n";
+void writeLatencyReport(const string& path) {
+    if (path.empty()) {
         return;
     }
-    if (root->word == word) {
-        if (root->left == nullptr) {
-            Node* temp = root->right;
-            delete root;
-            root = temp;
-        } else if (root->right == nullptr) {
-            Node* temp = root->left;
-            delete root;
-            root = temp;
-        } else {
-            Node* temp = root->right;
-            while (temp->left != nullptr) {
-                temp = temp->left;
-            }
-            root->word = temp->word;
-            root->meaning = temp->meaning;
-            root->grammaticalCategory = temp->grammaticalCategory;
-            for (int i = 0; i < 3; i++) {
-                root->synonyms[i] = temp->synonyms[i];
+    if (path == "-") {
+        printLatencyReport(cerr);
+        return;
+    }
+    ofstream out(path);
+    printLatencyReport(out);
+}
+
+// Shows a listing pageSize entries at a time, asking before each further page.
+// A pageSize of 0 shows the whole listing at once.
+void showListing(Dictionary* dictionary, ListingCursor cursor, LatencyOperation operation, size_t pageSize) {
+    while (true) {
+        {
+            LatencyTimer timer(operation);
+            size_t limit = pageSize == 0 ? SIZE_MAX : pageSize;
+            if (dictionary->frozen != nullptr) {
+                showFrozenPage(*dictionary->frozen, cursor, limit);
+            } else {
+                showPage(dictionary->root, cursor, limit, dictionary->lazy);
             }
-            deleteWord(root->right, temp->word);
         }
-    } else if (root->word > word) {
-        deleteWord(root->left, word);
-    } else {
-        deleteWord(root->right, word);
+        if (cursor.finished) {
+            return;
+        }
+        char answer;
+        cout << "Show more? (y/n): ";
+        cin >> answer;
+        if (answer != 'y' && answer != 'Y') {
+            return;
+        }
     }
 }
 
-void listByCategory(Node* root, string category) {
-    if (root == nullptr) {
-        return;
-    }
-    listByCategory(root->left, category);
-    if (root->grammaticalCategory == category) {
-        showWord(root);
+/*
+Usage: untitled2 [--load dictionary.tsv] [--load-lazy dictionary.tsv [--lazy-cache entries]]
+                 [--batch commands.tsv|-] [--bloom false-positive-rate] [--hot-cache slots]
+                 [--record trace.tsv] [--replay trace.tsv [--latencies latencies.csv]]
+                 [--stats-interval seconds] [--latency-report report.csv|-] [--page-size entries]
+                 [--threads count] [--hash-index on|off] [--scapegoat alpha]
+                 [--tombstones ratio]
+                 [--checkpoint manifest [--journal interval-ms [--journal-batch records]]]
+                 [--frozen dictionary.frozen]
+Without --batch or --replay the interactive menu is shown after loading.
+--bloom puts a Bloom filter with the given false positive rate in front of lookups.
+--hot-cache answers frequently searched words from a cache of that many nodes.
+--hash-index on answers exact lookups from a hash index instead of descending the tree.
+--scapegoat keeps the tree balanced by rebuilding subtrees that get more than alpha
+(0.5 to 1) of their parent's words, with no balance data in the nodes.
+--tombstones makes deletes only mark their node, and compacts the tree once more
+than ratio (0 to 1) of its nodes are marked.
+--load accepts both text dictionaries and frozen files written by the batch 'freeze' command.
+--frozen serves a frozen file read-only without building the tree (see frozenview.h);
+it cannot be combined with --load, --load-lazy or --checkpoint.
+--load-lazy keeps only words and categories in memory and reads meanings and
+synonyms from the file when shown, caching up to --lazy-cache entries (default 1024).
+--record appends the session's operations as batch commands, so the trace can be
+replayed with --batch or timed with --replay.
+--stats-interval dumps the instrumentation statistics to stderr periodically.
+--latency-report writes the per-operation latency percentiles at exit.
+--checkpoint loads the dictionary from that checkpoint, or starts one with the
+loaded words, and writes the session's changes to it incrementally at exit.
+--journal also journals every change from a background thread, flushing at least
+every interval-ms milliseconds or --journal-batch changes (default 256); an interval
+of 0 flushes only on full batches.
+--page-size sets how many entries the menu listings show per page (default 20, 0 for all).
+--threads runs word counts and the batch 'category' command on that many threads;
+the menu listings are paged and stay sequential.
+*/
+// Parses the value of a numeric option, reporting a bad one.
+template <typename T>
+static bool optionValue(const string& flag, const string& text, T& value) {
+    if (parseNumber(text, value)) {
+        return true;
     }
-    listByCategory(root->right, category);
+    cerr << "Invalid value for " << flag << ": " << text << "\n";
+    return false;
 }
 
-void listByLetter(Node* root, char letter) {
-    if (root == nullptr) {
-        return;
-    }
-    listByLetter(root->left, letter);
-    if (root->word[0] == letter) {
-        showWord(root);
+int main(int argc, char** argv) {
+    Dictionary dictionary;
+    dictionary.root = nullptr;
+    string batchPath, replayPath, latenciesPath, latencyReportPath, lazyPath, checkpointPath, frozenPath;
+    size_t lazyCache = 1024;
+    size_t journalBatch = 256;
+    int journalInterval = -1;
+    size_t pageSize = 20;
+    TraceRecorder trace;
+    TraceRecorder* recorder = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string flag = argv[i];
+        string value = argv[i + 1];
+        if (flag == "--load") {
+            int loaded = loadDictionaryFile(&dictionary, argv[i + 1]);
+            if (loaded < 0) {
+                cerr << "Cannot load " << argv[i + 1] << "\n";
+                return 1;
+            }
+            cerr << "Loaded " << loaded << " words.\n";
+        } else if (flag == "--bloom") {
+            double ratio;
+            if (!optionValue(flag, value, ratio)) {
+                return 1;
+            }
+            enableBloomFilter(&dictionary, ratio);
+        } else if (flag == "--hash-index") {
+            if (string(argv[i + 1]) == "on") {
+                enableHashIndex(&dictionary);
+            } else {
+                disableHashIndex(&dictionary);
+            }
+        } else if (flag == "--scapegoat") {
+            double ratio;
+            if (!optionValue(flag, value, ratio)) {
+                return 1;
+            }
+            enableScapegoat(&dictionary, ratio);
+        } else if (flag == "--tombstones") {
+            double ratio;
+            if (!optionValue(flag, value, ratio)) {
+                return 1;
+            }
+            enableTombstones(&dictionary, ratio);
+        } else if (flag == "--hot-cache") {
+            size_t slots;
+            if (!optionValue(flag, value, slots)) {
+                return 1;
+            }
+            enableHotCache(&dictionary, slots);
+        } else if (flag == "--frozen") {
+            frozenPath = argv[i + 1];
+        } else if (flag == "--load-lazy") {
+            lazyPath = argv[i + 1];
+        } else if (flag == "--lazy-cache") {
+            if (!optionValue(flag, value, lazyCache)) {
+                return 1;
+            }
+        } else if (flag == "--threads") {
+            unsigned threads;
+            if (!optionValue(flag, value, threads)) {
+                return 1;
+            }
+            setTraversalThreads(threads);
+        } else if (flag == "--page-size") {
+            if (!optionValue(flag, value, pageSize)) {
+                return 1;
+            }
+        } else if (flag == "--checkpoint") {
+            checkpointPath = argv[i + 1];
+        } else if (flag == "--journal") {
+            if (!optionValue(flag, value, journalInterval)) {
+                return 1;
+            }
+        } else if (flag == "--journal-batch") {
+            if (!optionValue(flag, value, journalBatch)) {
+                return 1;
+            }
+        } else if (flag == "--batch") {
+            batchPath = argv[i + 1];
+        } else if (flag == "--replay") {
+            replayPath = argv[i + 1];
+        } else if (flag == "--stats-interval") {
+            int seconds;
+            if (!optionValue(flag, value, seconds)) {
+                return 1;
+            }
+            startStatsDump(seconds, cerr);
+        } else if (flag == "--latency-report") {
+            latencyReportPath = argv[i + 1];
+        } else if (flag == "--latencies") {
+            latenciesPath = argv[i + 1];
+        } else if (flag == "--record") {
+            trace.out.open(argv[i + 1], ios::app);
+            if (!trace.out) {
+                cerr << "Cannot open " << argv[i + 1] << "\n";
+                return 1;
+            }
+            recorder = &trace;
+        } else {
+            cerr << "Unknown option: " << flag << "\n";
+            return 1;
+        }
     }
-    listByLetter(root->right, letter);
-}
 
-void listAllWords (Node* root) {
-    if (root == nullptr) {
-        return;
+    if (!frozenPath.empty()) {
+        if (dictionary.root != nullptr || !lazyPath.empty() || !checkpointPath.empty()) {
+            cerr << "--frozen cannot be combined with --load, --load-lazy or --checkpoint.\n";
+            return 1;
+        }
+        long opened = openFrozenDictionary(&dictionary, frozenPath);
+        if (opened < 0) {
+            cerr << "Cannot load " << frozenPath << "\n";
+            return 1;
+        }
+        cerr << "Serving " << opened << " frozen words.\n";
     }
-    listAllWords(root->left);
-    showWord(root);
-    listAllWords(root->right);
-}
 
-void showFirstAndLast(Node* root) {
-    if (root == nullptr) {
-        cout << "Dictionary is empty.\n";
-        return;
+    if (!lazyPath.empty()) {
+        int loaded = loadDictionaryLazy(&dictionary, lazyPath, lazyCache);
+        if (loaded < 0) {
+            cerr << "Cannot open " << lazyPath << "\n";
+            return 1;
+        }
+        cerr << "Loaded " << loaded << " words lazily.\n";
     }
-    Node* first = root;
-    while (first->left != nullptr) {
-        first = first->left;
+
+    if (!checkpointPath.empty()) {
+        int loaded = openCheckpoint(&dictionary, checkpointPath);
+        if (loaded < 0) {
+            cerr << "Cannot open checkpoint " << checkpointPath << "\n";
+            return 1;
+        }
+        cerr << "Checkpoint holds " << loaded << " words.\n";
     }
-    Node* last = root;
-    while (last->right != nullptr) {
-        last = last->right;
+    if (journalInterval >= 0 && !startJournal(&dictionary, journalInterval, journalBatch)) {
+        cerr << "Cannot start the journal; it needs --checkpoint.\n";
+        return 1;
     }
-    cout << "First word: " << first->word << "\n";
-    showWord(first);
-    cout << "Last word: " << last->word << "\n";
-    showWord(last);
-}
 
-int countWords(Node* root) {
-    if (root == nullptr) {
-        return 0;
+    if (!batchPath.empty()) {
+        int failed;
+        if (batchPath == "-") {
+            failed = runBatch(&dictionary, cin);
+        } else {
+            ifstream in(batchPath);
+            if (!in) {
+                cerr << "Cannot open " << batchPath << "\n";
+                return 1;
+            }
+            failed = runBatch(&dictionary, in);
+        }
+        stopStatsDump();
+        writeLatencyReport(latencyReportPath);
+        writeCheckpoint(&dictionary);
+        closeCheckpoint(&dictionary);
+        closeFrozenDictionary(&dictionary);
+        destroyTree(dictionary.root, dictionary.lazy);
+        return failed == 0 ? 0 : 1;
     }
-    return 1 + countWords(root->left) + countWords(root->right);
-}
 
-Node *searchWord(Node *root, string word) {
-    if (root == nullptr || root->word == word) {
-        return root;
-    }
-    if (strcasecmp(word.c_str(), root->word.c_str()) < 0) {
-        return searchWord(root->left, word);
+    if (!replayPath.empty()) {
+        ifstream in(replayPath);
+        if (!in) {
+            cerr << "Cannot open " << replayPath << "\n";
+            return 1;
+        }
+        ofstream latencies;
+        if (!latenciesPath.empty()) {
+            latencies.open(latenciesPath);
+        }
+        int failed = replayTrace(&dictionary, in, cout, latenciesPath.empty() ? nullptr : &latencies);
+        stopStatsDump();
+        writeLatencyReport(latencyReportPath);
+        writeCheckpoint(&dictionary);
+        closeCheckpoint(&dictionary);
+        closeFrozenDictionary(&dictionary);
+        destroyTree(dictionary.root, dictionary.lazy);
+        return failed == 0 ? 0 : 1;
     }
-    return searchWord(root->right, word);
-}
-
-void displayMenu() {
-    cout << "Menu:\n";
-    cout << "1. Add word to dictionary\n";
-    cout << "2. Modify elements of a word\n";
-    cout << "3. Show elements of a word\n";
-    cout << "4. Delete word\n";
-    cout << "5. List of words by grammatical category\n";
-    cout << "6. List of words by letter\n";
-    cout << "7. General list of words in alphabetical order\n";
-    cout << "8. Show the first and last word of the dictionary with their components\n";
-    cout << "9. Show the number of words registered in the dictionary\n";
-    cout << "10. Exit\n";
-}
 
-int main() {
-    Dictionary dictionary;
-    dictionary.root = nullptr;
     int choice;
 
     do {
         displayMenu();
         cout << "Enter your choice: ";
         cin >> choice;
+        if (dictionary.frozen != nullptr && (choice == 1 || choice == 2 || choice == 4)) {
+            cout << "The frozen dictionary is read-only.\n";
+            continue;
+        }
         switch (choice) {
             case 1:
-                addWordMenu(&dictionary);
+                addWordMenu(&dictionary, recorder);
             break;
             case 2: {
                 string word;
                 cout << "Enter the word to modify: ";
                 cin >> word;
-                Node *found = searchWord(dictionary.root, word);
-                modifyWordMenu(found);
+                Node *found;
+                {
+                    LatencyTimer timer(LAT_MODIFY);
+                    found = searchWord(&dictionary, word);
+                }
+                if (found == nullptr) {
+                    recordOperation(recorder, {"search", word});
+                    cout << "Word not found.\n";
+                } else {
+                    modifyWordMenu(&dictionary, found, recorder);
+                }
                 break;
             }
             case 3: {
                 string word;
                 cout << "Enter the word to show: ";
                 cin >> word;
-                Node *found = searchWord(dictionary.root, word);
-                showWord(found);
+                if (dictionary.frozen != nullptr) {
+                    LatencyTimer timer(LAT_SHOW);
+                    if (!showFrozenWord(*dictionary.frozen, word)) {
+                        cout << "Word not found.\n";
+                    }
+                } else {
+                    LatencyTimer timer(LAT_SHOW);
+                    Node *found = searchWord(&dictionary, word);
+                    if (found == nullptr) {
+                        cout << "Word not found.\n";
+                    } else {
+                        showWord(found, dictionary.lazy);
+                    }
+                }
+                recordOperation(recorder, {"show", word});
                 break;
             }
             case 4: {
                 string word;
                 cout << "Enter the word to delete: ";
                 cin >> word;
-                deleteWord(dictionary.root, word);
+                {
+                    LatencyTimer timer(LAT_DELETE);
+                    deleteWord(&dictionary, word);
+                }
+                recordOperation(recorder, {"delete", word});
                 break;
             }
             case 5: {
                 string category;
                 cout << "Enter the grammatical category: ";
                 cin >> category;
-                listByCategory(dictionary.root, category);
+                showListing(&dictionary, makeListingCursor(LISTING_CATEGORY, category), LAT_LIST_CATEGORY, pageSize);
                 break;
             }
             case 6: {
                 char letter;
                 cout << "Enter the letter: ";
                 cin >> letter;
-                listByLetter(dictionary.root, letter);
+                showListing(&dictionary, makeListingCursor(LISTING_LETTER, string(1, letter)), LAT_LIST_LETTER,
+                            pageSize);
                 break;
             }
             case 7:
-                listAllWords(dictionary.root);
+                showListing(&dictionary, makeListingCursor(LISTING_ALL, ""), LAT_LIST_ALL, pageSize);
+                break;
+            case 8: {
+                LatencyTimer timer(LAT_FIRST_LAST);
+                if (dictionary.frozen != nullptr) {
+                    showFrozenFirstAndLast(*dictionary.frozen);
+                } else {
+                    showFirstAndLast(dictionary.root, dictionary.lazy);
+                }
+                break;
+            }
+            case 9: {
+                LatencyTimer timer(LAT_COUNT);
+                long count = dictionary.frozen != nullptr ? (long) dictionary.frozen->count
+                                                          : parallelCountWords(dictionary.root);
+                cout << "Number of words in the dictionary: " << count << "\n";
+                break;
+            }
+            case 10:
+                cout << "Exiting program...\n";
             break;
-            case 8:
-                showFirstAndLast(dictionary.root);
+            case 11:
+                printStats(cout);
             break;
-            case 9:
-                cout << "Number of words in the dictionary: " << countWords(dictionary.root) << "\n";
+            case 12:
+                printLatencyReport(cout);
             break;
-            case 10:
-                cout << "Exiting program...\n";
+            case 13:
+                printTreeShape(analyzeTree(dictionary.root), cout);
+            break;
+            case 14:
+                if (dictionary.frozen != nullptr) {
+                    printFrozenStats(*dictionary.frozen, cout);
+                } else {
+                    printMemoryReport(measureMemory(&dictionary), cout);
+                }
             break;
             default:
                 cout << "Invalid choice. Please try again.\n";
         }
     } while (choice != 10);
+    stopStatsDump();
+    writeLatencyReport(latencyReportPath);
+    writeCheckpoint(&dictionary);
+    closeCheckpoint(&dictionary);
+    closeFrozenDictionary(&dictionary);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "memory.h"
+
+#include <cstdio>
+#include <malloc.h>
+#include <string>
+#include <vector>
+
+#include "bloom.h"
+#include "hashindex.h"
+#include "hotcache.h"
+#include "lazy.h"
+#include "persistent.h"
+
+using namespace std;
+
+// A string short enough for the buffer inside its header keeps its characters there.
+static bool isSmall(const string& text) {
+    const char* data = text.data();
+    const char* header = reinterpret_cast<const char*>(&text);
+    return data >= header && data < header + sizeof(string);
+}
+
+static void measureString(const string& text, StringFieldUsage& usage) {
+    usage.strings++;
+    usage.payloadBytes += text.size();
+    if (text.empty()) {
+        usage.empty++;
+    }
+    if (isSmall(text)) {
+        usage.small++;
+        return;
+    }
+    usage.heap++;
+    usage.requestedBytes += text.capacity() + 1;
+    usage.allocatedBytes += malloc_usable_size(const_cast<char*>(text.data()));
+}
+
+MemoryReport measureMemory(const Dictionary* dictionary) {
+    MemoryReport report = {};
+    vector<Node*> stack;
+    if (dictionary->root != nullptr) {
+        stack.push_back(dictionary->root);
+    }
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        report.nodes++;
+        report.tombstones += node->tombstone ? 1 : 0;
+        report.nodeAllocatedBytes += malloc_usable_size(node);
+        measureString(node->word, report.word);
+        measureString(node->grammaticalCategory, report.category);
+        // Meaning and synonyms of a lazy entry are on disk, and in memory only while it is cached.
+        bool resident = true;
+        if (node->offset >= 0) {
+            report.lazyEntries++;
+            resident = dictionary->lazy != nullptr && dictionary->lazy->resident.count(node) > 0;
+            report.lazyResident += resident ? 1 : 0;
+        }
+        if (resident) {
+            measureString(node->meaning, report.meaning);
+            for (const string& synonym : node->synonyms) {
+                measureString(synonym, report.synonyms);
+            }
+        }
+        if (node->right != nullptr) {
+            stack.push_back(node->right);
+        }
+        if (node->left != nullptr) {
+            stack.push_back(node->left);
+        }
+    }
+    report.nodeBytes = report.nodes * sizeof(Node);
+    report.headerBytes = report.nodes * (sizeof(Node::word) + sizeof(Node::meaning)
+                                          + sizeof(Node::grammaticalCategory) + sizeof(Node::synonyms));
+    report.linkBytes = report.nodes * 2 * sizeof(Node*);
+    report.offsetBytes = report.nodes * sizeof(Node::offset);
+
+    if (dictionary->index != nullptr) {
+        report.hashIndexBytes = dictionary->index->control.capacity()
+                                + dictionary->index->nodes.capacity() * sizeof(Node*);
+    }
+    if (dictionary->filter != nullptr) {
+        report.bloomBytes = dictionary->filter->bits.capacity() * sizeof(uint64_t);
+    }
+    if (dictionary->hotCache != nullptr) {
+        report.hotCacheBytes = dictionary->hotCache->slots.capacity() * sizeof(HotSlot);
+    }
+    if (dictionary->lazy != nullptr) {
+        const LazyStore* lazy = dictionary->lazy;
+        // A list node carries two links, a map node its next link, beside the values;
+        // the file keeps a BUFSIZ read buffer.
+        size_t listNode = sizeof(Node*) + 2 * sizeof(void*);
+        size_t mapNode = sizeof(void*) + sizeof(pair<Node* const, list<Node*>::iterator>);
+        report.lazyStoreBytes = sizeof(LazyStore) + BUFSIZ + lazy->recent.size() * listNode
+                                + lazy->resident.size() * mapNode + lazy->resident.bucket_count() * sizeof(void*);
+        if (!isSmall(lazy->path)) {
+            report.lazyStoreBytes += malloc_usable_size(const_cast<char*>(lazy->path.data()));
+        }
+    }
+    if (dictionary->versions != nullptr) {
+        // make_shared puts the two reference counts and the control block's vtable
+        // pointer in front of every version node and entry.
+        size_t control = 2 * sizeof(int) + sizeof(void*);
+        Snapshot version = dictionary->versions->root.load();
+        vector<const PersistentNode*> nodes;
+        if (version != nullptr) {
+            nodes.push_back(version.get());
+        }
+        while (!nodes.empty()) {
+            const PersistentNode* node = nodes.back();
+            nodes.pop_back();
+            report.versionNodes++;
+            const WordEntry& entry = *node->entry;
+            measureString(entry.word, report.versionStrings);
+            measureString(entry.meaning, report.versionStrings);
+            measureString(entry.grammaticalCategory, report.versionStrings);
+            for (const string& synonym : entry.synonyms) {
+                measureString(synonym, report.versionStrings);
+            }
+            if (node->right != nullptr) {
+                nodes.push_back(node->right.get());
+            }
+            if (node->left != nullptr) {
+                nodes.push_back(node->left.get());
+            }
+        }
+        report.versionNodeBytes = report.versionNodes * (sizeof(PersistentNode) + sizeof(WordEntry) + 2 * control);
+        const vector<string>& changed = dictionary->versions->changed;
+        report.versionChangedBytes = changed.capacity() * sizeof(string);
+        for (const string& word : changed) {
+            if (!isSmall(word)) {
+                report.versionChangedBytes += malloc_usable_size(const_cast<char*>(word.data()));
+            }
+        }
+    }
+    return report;
+}
+
+static double percent(uint64_t part, uint64_t total) {
+    return total > 0 ? 100.0 * part / total : 0;
+}
+
+static void printField(const char* name, const StringFieldUsage& usage, ostream& out) {
+    out << name << ": " << usage.strings << " strings (" << usage.empty << " empty, " << usage.small
+        << " in place, " << usage.heap << " on the heap), " << usage.payloadBytes << " characters, "
+        << usage.requestedBytes << " heap bytes requested, " << usage.allocatedBytes << " allocated\n";
+}
+
+void printMemoryReport(const MemoryReport& report, ostream& out) {
+    const StringFieldUsage* fields[] = {&report.word, &report.meaning, &report.category, &report.synonyms};
+    uint64_t payload = 0, requested = 0, allocated = 0;
+    for (const StringFieldUsage* field : fields) {
+        payload += field->payloadBytes;
+        requested += field->requestedBytes;
+        allocated += field->allocatedBytes;
+    }
+    uint64_t accelerators = report.hashIndexBytes + report.bloomBytes + report.hotCacheBytes;
+    uint64_t versions = report.versionNodeBytes + report.versionStrings.allocatedBytes + report.versionChangedBytes;
+    uint64_t total = report.nodeAllocatedBytes + allocated + accelerators + report.lazyStoreBytes + versions;
+
+    out << "Nodes: " << report.nodes << " x " << sizeof(Node) << " bytes = " << report.nodeBytes
+        << " (" << report.nodeAllocatedBytes << " allocated)\n";
+    out << "  string headers " << report.headerBytes << ", child pointers " << report.linkBytes
+        << ", lazy offsets " << report.offsetBytes << "\n";
+    if (report.tombstones > 0) {
+        out << "Tombstones awaiting compaction: " << report.tombstones << "\n";
+    }
+    if (report.lazyEntries > 0) {
+        out << "Lazy entries: " << report.lazyEntries << ", " << report.lazyResident
+            << " with meaning and synonyms cached, the rest on disk; store " << report.lazyStoreBytes << " bytes\n";
+    }
+    printField("word", report.word, out);
+    printField("meaning", report.meaning, out);
+    printField("category", report.category, out);
+    printField("synonyms", report.synonyms, out);
+    out << "Empty synonym slots: " << report.synonyms.empty << " of " << report.synonyms.strings
+        << " (" << percent(report.synonyms.empty, report.synonyms.strings) << "%)\n";
+    out << "Accelerators: hash index " << report.hashIndexBytes << ", Bloom filter " << report.bloomBytes
+        << ", hot cache " << report.hotCacheBytes << "\n";
+    if (report.versionNodes > 0 || report.versionChangedBytes > 0) {
+        out << "Snapshot version: " << report.versionNodes << " nodes, " << report.versionNodeBytes
+            << " bytes of nodes and entries, " << report.versionChangedBytes << " bytes of changed words\n";
+        printField("snapshot strings", report.versionStrings, out);
+    }
+    out << "Allocator slack: nodes " << report.nodeAllocatedBytes - report.nodeBytes
+        << ", string buffers " << allocated - requested << "\n";
+    out << "Total: " << total << " bytes; characters " << payload << " (" << percent(payload, total)
+        << "%), string headers " << percent(report.headerBytes, total) << "%, child pointers "
+        << percent(report.linkBytes, total) << "%\n";
+}
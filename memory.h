@@ -0,0 +1,60 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <cstdint>
+#include <ostream>
+
+#include "dictionary.h"
+
+/*
+Memory accounting for the tree. One walk with an explicit stack visits every node
+and adds up, per string field, how many strings fit the small-string buffer inside
+their header and how many own a heap buffer, the characters stored, the capacity
+requested from the allocator and what it actually handed out (malloc_usable_size).
+The node allocation itself is split into string headers, child pointers and the
+lazy offset. The accelerators' tables are added as they are allocated. The lazy
+store's cache bookkeeping and the snapshot version tree live in container and
+make_shared nodes, so their sizes are estimated from the element counts.
+
+Slack is allocated minus requested bytes; payload is the characters of the fields.
+*/
+struct StringFieldUsage {
+    long strings;
+    long empty;
+    long small;
+    long heap;
+    uint64_t payloadBytes;
+    uint64_t requestedBytes;
+    uint64_t allocatedBytes;
+};
+
+struct MemoryReport {
+    long nodes;
+    long tombstones;
+    // Lazy entries read their meaning and synonyms from the file; the resident ones
+    // currently hold them in memory as well.
+    long lazyEntries;
+    long lazyResident;
+    uint64_t nodeBytes;
+    uint64_t nodeAllocatedBytes;
+    uint64_t headerBytes;
+    uint64_t linkBytes;
+    uint64_t offsetBytes;
+    StringFieldUsage word;
+    StringFieldUsage meaning;
+    StringFieldUsage category;
+    StringFieldUsage synonyms;
+    uint64_t hashIndexBytes;
+    uint64_t bloomBytes;
+    uint64_t hotCacheBytes;
+    uint64_t lazyStoreBytes;
+    long versionNodes;
+    uint64_t versionNodeBytes;
+    StringFieldUsage versionStrings;
+    uint64_t versionChangedBytes;
+};
+
+MemoryReport measureMemory(const Dictionary* dictionary);
+void printMemoryReport(const MemoryReport& report, std::ostream& out);
+
+#endif
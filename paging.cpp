@@ -0,0 +1,75 @@
+#include "paging.h"
+
+#include <cctype>
+#include <strings.h>
+
+#include "iterator.h"
+#include "stats.h"
+
+using namespace std;
+
+ListingCursor makeListingCursor(ListingKind kind, const string& filter, const string& after) {
+    ListingCursor cursor;
+    cursor.kind = kind;
+    if (kind == LISTING_CATEGORY) {
+        cursor.category = filter;
+    } else if (kind == LISTING_LETTER && !filter.empty()) {
+        cursor.letter = filter[0];
+    }
+    cursor.after = after;
+    return cursor;
+}
+
+#ifdef DICTIONARY_INSTRUMENTATION
+static StatOperation statOperation(ListingKind kind) {
+    if (kind == LISTING_CATEGORY) {
+        return STAT_LIST_CATEGORY;
+    }
+    return kind == LISTING_LETTER ? STAT_LIST_LETTER : STAT_LIST_ALL;
+}
+#endif
+
+size_t showPage(Node* root, ListingCursor& cursor, size_t pageSize, LazyStore* lazy) {
+    STAT_SCOPE(statOperation(cursor.kind), nullptr);
+    DictionaryView words = dictionaryView(root);
+    DictionaryIterator it = cursor.after.empty() ? words.begin() : words.upper_bound(cursor.after);
+
+    // Words with the same first letter (ignoring case) are contiguous; jump to their run.
+    string letter(1, cursor.letter);
+    int folded = tolower((unsigned char) cursor.letter);
+    if (cursor.kind == LISTING_LETTER
+        && (cursor.after.empty() || strcasecmp(cursor.after.c_str(), letter.c_str()) < 0)) {
+        it = words.lower_bound(letter);
+    }
+
+    // Scans one matching entry past a full page, so a listing that ends exactly at
+    // the page boundary is reported finished without an empty page after it.
+    size_t shown = 0;
+    bool more = false;
+    for (; it != words.end(); ++it) {
+        STAT_VISIT(it.depth());
+        bool matches = true;
+        if (cursor.kind == LISTING_CATEGORY) {
+            STAT_COMPARE();
+            matches = it->grammaticalCategory == cursor.category;
+        } else if (cursor.kind == LISTING_LETTER) {
+            STAT_COMPARE();
+            if (tolower((unsigned char) it->word[0]) != folded) {
+                break;
+            }
+            matches = it->word[0] == cursor.letter;
+        }
+        if (!matches) {
+            continue;
+        }
+        if (shown == pageSize) {
+            more = true;
+            break;
+        }
+        showWord(&*it, lazy);
+        cursor.after = it->word;
+        shown++;
+    }
+    cursor.finished = !more;
+    return shown;
+}
@@ -0,0 +1,37 @@
+#ifndef PAGING_H
+#define PAGING_H
+
+#include <cstddef>
+#include <string>
+
+#include "dictionary.h"
+
+enum ListingKind {
+    LISTING_ALL,
+    LISTING_CATEGORY,
+    LISTING_LETTER
+};
+
+/*
+Resumable position in one of the listings (all words, by category, by letter).
+after is the last word shown; callers should treat it as an opaque token. It is a
+key rather than a node, so a cursor stays valid when words are added or deleted
+between pages: the next page simply starts after that key in the current tree.
+*/
+struct ListingCursor {
+    ListingKind kind = LISTING_ALL;
+    std::string category;
+    char letter = 0;
+    std::string after;
+    bool finished = false;
+};
+
+ListingCursor makeListingCursor(ListingKind kind, const std::string& filter, const std::string& after = "");
+
+// Shows up to pageSize entries following the cursor and advances it. Seeking to
+// the cursor is O(log n); the category listing also walks the non-matching words
+// it skips, up to the first match after the page, which decides cursor.finished.
+// Returns the number of entries shown.
+size_t showPage(Node* root, ListingCursor& cursor, size_t pageSize, LazyStore* lazy);
+
+#endif
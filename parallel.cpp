@@ -0,0 +1,252 @@
+#include "parallel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "iterator.h"
+
+using namespace std;
+
+class WorkStealingPool {
+public:
+    // The calling thread takes part in run(), so threads - 1 workers are started.
+    explicit WorkStealingPool(unsigned threads) : queues(threads), queued(0), running(0), stopping(false) {
+        for (unique_ptr<WorkerQueue>& queue : queues) {
+            queue = make_unique<WorkerQueue>();
+        }
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+        }
+    }
+
+    ~WorkStealingPool() {
+        {
+            lock_guard<mutex> guard(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    unsigned size() const { return (unsigned) queues.size(); }
+
+    // Runs every task and returns once all of them have finished.
+    void run(vector<function<void()>>& tasks) {
+        running += tasks.size();
+        for (size_t i = 0; i < tasks.size(); i++) {
+            WorkerQueue& queue = *queues[i % queues.size()];
+            lock_guard<mutex> guard(queue.lock);
+            queue.tasks.push_back(move(tasks[i]));
+        }
+        {
+            lock_guard<mutex> guard(sleepLock);
+            queued += tasks.size();
+        }
+        wake.notify_all();
+        while (running > 0) {
+            if (!runOne(0)) {
+                this_thread::yield();
+            }
+        }
+    }
+
+private:
+    struct WorkerQueue {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<WorkerQueue>> queues;
+    vector<thread> workers;
+    mutex sleepLock;
+    condition_variable wake;
+    size_t queued;
+    atomic<size_t> running;
+    bool stopping;
+
+    // Takes the newest task of its own queue, or else the oldest of another's.
+    bool runOne(unsigned self) {
+        function<void()> task;
+        for (unsigned i = 0; i < queues.size() && !task; i++) {
+            WorkerQueue& queue = *queues[(self + i) % queues.size()];
+            lock_guard<mutex> guard(queue.lock);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (i == 0) {
+                task = move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+        if (!task) {
+            return false;
+        }
+        {
+            lock_guard<mutex> guard(sleepLock);
+            queued--;
+        }
+        task();
+        running--;
+        return true;
+    }
+
+    void workerLoop(unsigned self) {
+        while (true) {
+            {
+                unique_lock<mutex> guard(sleepLock);
+                wake.wait(guard, [this] { return stopping || queued > 0; });
+                if (stopping) {
+                    return;
+                }
+            }
+            runOne(self);
+        }
+    }
+};
+
+static unique_ptr<WorkStealingPool> pool;
+
+void setTraversalThreads(unsigned threads) {
+    if (threads <= 1) {
+        pool.reset();
+    } else if (pool == nullptr || pool->size() != threads) {
+        pool.reset();
+        pool = make_unique<WorkStealingPool>(threads);
+    }
+}
+
+unsigned traversalThreads() {
+    return pool == nullptr ? 1 : pool->size();
+}
+
+// Either a whole subtree or one node lying between two cut subtrees.
+struct Segment {
+    Node* node;
+    bool wholeSubtree;
+};
+
+static void cutTree(Node* node, int depth, vector<Segment>& segments) {
+    if (node == nullptr) {
+        return;
+    }
+    if (depth == 0) {
+        segments.push_back({node, true});
+        return;
+    }
+    cutTree(node->left, depth - 1, segments);
+    segments.push_back({node, false});
+    cutTree(node->right, depth - 1, segments);
+}
+
+// About eight segments per thread leaves enough spare work to steal.
+static vector<Segment> cutForPool(Node* root) {
+    int depth = 0;
+    while ((1u << depth) < traversalThreads() * 8) {
+        depth++;
+    }
+    vector<Segment> segments;
+    cutTree(root, depth, segments);
+    return segments;
+}
+
+vector<Node*> parallelFilter(Node* root, const function<bool(const Node*)>& match) {
+    vector<Node*> matches;
+    if (pool == nullptr) {
+        for (Node& node : dictionaryView(root)) {
+            if (match(&node)) {
+                matches.push_back(&node);
+            }
+        }
+        return matches;
+    }
+
+    vector<Segment> segments = cutForPool(root);
+    vector<vector<Node*>> results(segments.size());
+    vector<function<void()>> tasks;
+    tasks.reserve(segments.size());
+    for (size_t i = 0; i < segments.size(); i++) {
+        tasks.push_back([&, i] {
+            if (!segments[i].wholeSubtree) {
+                if (!segments[i].node->tombstone && match(segments[i].node)) {
+                    results[i].push_back(segments[i].node);
+                }
+                return;
+            }
+            for (Node& node : dictionaryView(segments[i].node)) {
+                if (match(&node)) {
+                    results[i].push_back(&node);
+                }
+            }
+        });
+    }
+    pool->run(tasks);
+
+    size_t total = 0;
+    for (const vector<Node*>& result : results) {
+        total += result.size();
+    }
+    matches.reserve(total);
+    for (const vector<Node*>& result : results) {
+        matches.insert(matches.end(), result.begin(), result.end());
+    }
+    return matches;
+}
+
+void parallelListByCategory(Node* root, const string& category, LazyStore* lazy) {
+    if (pool == nullptr) {
+        listByCategory(root, category, lazy);
+        return;
+    }
+    vector<Node*> matches = parallelFilter(root, [&category](const Node* node) {
+        return node->grammaticalCategory == category;
+    });
+    for (Node* node : matches) {
+        showWord(node, lazy);
+    }
+}
+
+int parallelCountWords(Node* root) {
+    if (pool == nullptr) {
+        return countWords(root);
+    }
+    vector<Segment> segments = cutForPool(root);
+    vector<int> counts(segments.size());
+    vector<function<void()>> tasks;
+    tasks.reserve(segments.size());
+    for (size_t i = 0; i < segments.size(); i++) {
+        tasks.push_back([&, i] {
+            if (!segments[i].wholeSubtree) {
+                counts[i] = segments[i].node->tombstone ? 0 : 1;
+                return;
+            }
+            vector<Node*> stack = {segments[i].node};
+            while (!stack.empty()) {
+                Node* node = stack.back();
+                stack.pop_back();
+                counts[i] += node->tombstone ? 0 : 1;
+                if (node->left != nullptr) {
+                    stack.push_back(node->left);
+                }
+                if (node->right != nullptr) {
+                    stack.push_back(node->right);
+                }
+            }
+        });
+    }
+    pool->run(tasks);
+
+    int total = 0;
+    for (int count : counts) {
+        total += count;
+    }
+    return total;
+}
@@ -0,0 +1,32 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "dictionary.h"
+
+/*
+Parallel full-tree traversals. The tree is cut a few levels below the root into
+in-order segments (whole subtrees and the single nodes between them), several per
+thread, which are filtered on a work-stealing pool: each thread drains its own
+queue and then steals from the others, so uneven subtrees still spread over the
+cores. Segment results are concatenated in segment order, which keeps matches in
+alphabetical order. Entries are printed by the calling thread afterwards.
+
+Traversals must not run concurrently with changes to the tree.
+*/
+
+// Number of threads used by the parallel traversals; 1 (the default) makes them
+// fall back to the sequential functions.
+void setTraversalThreads(unsigned threads);
+unsigned traversalThreads();
+
+// Matching nodes in alphabetical order. match is called from several threads.
+std::vector<Node*> parallelFilter(Node* root, const std::function<bool(const Node*)>& match);
+
+void parallelListByCategory(Node* root, const std::string& category, LazyStore* lazy);
+int parallelCountWords(Node* root);
+
+#endif
@@ -0,0 +1,361 @@
+#include "persistent.h"
+
+#include <algorithm>
+#include <cmath>
+#include <strings.h>
+#include <vector>
+
+#include "lazy.h"
+
+using namespace std;
+
+Snapshot takeSnapshot(PersistentDictionary* dictionary) {
+    return dictionary->root.load(memory_order_acquire);
+}
+
+// Heavier side a subtree may have before an insert below it rebuilds it, as in scapegoat.cpp.
+static const double balance = 0.7;
+
+PersistentNode::~PersistentNode() {
+    // Children that die with this node are queued on the outermost destructor running
+    // on this thread, which releases them one at a time.
+    static thread_local vector<Snapshot>* pending = nullptr;
+    if (left == nullptr && right == nullptr) {
+        return;
+    }
+    if (pending != nullptr) {
+        pending->push_back(move(left));
+        pending->push_back(move(right));
+        return;
+    }
+    vector<Snapshot> queue;
+    pending = &queue;
+    queue.push_back(move(left));
+    queue.push_back(move(right));
+    while (!queue.empty()) {
+        Snapshot node = move(queue.back());
+        queue.pop_back();
+    }
+    pending = nullptr;
+}
+
+// Built non-const so that the destructor may take the children of a dying node.
+static Snapshot makeNode(shared_ptr<const WordEntry> entry, Snapshot left, Snapshot right) {
+    return make_shared<PersistentNode>(move(entry), move(left), move(right));
+}
+
+static size_t subtreeSize(const PersistentNode* root) {
+    size_t size = 0;
+    vector<const PersistentNode*> stack;
+    if (root != nullptr) {
+        stack.push_back(root);
+    }
+    while (!stack.empty()) {
+        const PersistentNode* node = stack.back();
+        stack.pop_back();
+        size++;
+        if (node->left != nullptr) {
+            stack.push_back(node->left.get());
+        }
+        if (node->right != nullptr) {
+            stack.push_back(node->right.get());
+        }
+    }
+    return size;
+}
+
+static void flattenSnapshot(const PersistentNode* root, vector<shared_ptr<const WordEntry>>& entries) {
+    vector<const PersistentNode*> stack;
+    const PersistentNode* current = root;
+    while (current != nullptr || !stack.empty()) {
+        while (current != nullptr) {
+            stack.push_back(current);
+            current = current->left.get();
+        }
+        current = stack.back();
+        stack.pop_back();
+        entries.push_back(current->entry);
+        current = current->right.get();
+    }
+}
+
+static Snapshot buildBalanced(vector<shared_ptr<const WordEntry>>& entries, int low, int high) {
+    if (low > high) {
+        return nullptr;
+    }
+    int middle = low + (high - low) / 2;
+    return makeNode(entries[middle], buildBalanced(entries, low, middle - 1), buildBalanced(entries, middle + 1, high));
+}
+
+static Snapshot rebuildBalanced(const Snapshot& root) {
+    vector<shared_ptr<const WordEntry>> entries;
+    flattenSnapshot(root.get(), entries);
+    return buildBalanced(entries, 0, (int) entries.size() - 1);
+}
+
+// Copies the path from the root down to the entry's position, bottom-up. Returns the
+// new root, or null when nothing changed. The caller holds the writer lock.
+static Snapshot insertPath(PersistentDictionary* dictionary, const Snapshot& root,
+                           const shared_ptr<const WordEntry>& entry, bool replace) {
+    vector<const PersistentNode*> path;
+    const PersistentNode* node = root.get();
+    while (node != nullptr) {
+        int order = strcasecmp(entry->word.c_str(), node->entry->word.c_str());
+        if (order == 0) {
+            break;
+        }
+        path.push_back(node);
+        node = order < 0 ? node->left.get() : node->right.get();
+    }
+    if ((node != nullptr) != replace) {
+        return nullptr;
+    }
+    Snapshot child;
+    bool unbalanced = false;
+    if (node != nullptr) {
+        child = makeNode(entry, node->left, node->right);
+    } else {
+        child = makeNode(entry, nullptr, nullptr);
+        dictionary->size++;
+        dictionary->maxSize = max(dictionary->maxSize, dictionary->size);
+        unbalanced = (double) path.size() > log((double) dictionary->size) / log(1.0 / balance);
+    }
+    size_t childSize = 1;
+    for (size_t i = path.size(); i-- > 0;) {
+        const PersistentNode* parent = path[i];
+        bool left = strcasecmp(entry->word.c_str(), parent->entry->word.c_str()) < 0;
+        const PersistentNode* sibling = left ? parent->right.get() : parent->left.get();
+        Snapshot updated = left ? makeNode(parent->entry, child, parent->right)
+                                : makeNode(parent->entry, parent->left, child);
+        // Subtree sizes are only needed on the way up from an insert that is too deep.
+        if (unbalanced) {
+            size_t size = 1 + childSize + subtreeSize(sibling);
+            if ((double) childSize > balance * (double) size) {
+                updated = rebuildBalanced(updated);
+                unbalanced = false;
+            }
+            childSize = size;
+        }
+        child = move(updated);
+    }
+    return child;
+}
+
+static Snapshot deletePath(const Snapshot& root, const string& word, bool& deleted) {
+    vector<const PersistentNode*> path;
+    const PersistentNode* node = root.get();
+    while (node != nullptr) {
+        int order = strcasecmp(word.c_str(), node->entry->word.c_str());
+        if (order == 0) {
+            break;
+        }
+        path.push_back(node);
+        node = order < 0 ? node->left.get() : node->right.get();
+    }
+    if (node == nullptr) {
+        return root;
+    }
+    deleted = true;
+    Snapshot child;
+    if (node->left == nullptr) {
+        child = node->right;
+    } else if (node->right == nullptr) {
+        child = node->left;
+    } else {
+        // The successor's entry is shared, not copied, into the replacement node.
+        vector<const PersistentNode*> chain;
+        const PersistentNode* successor = node->right.get();
+        while (successor->left != nullptr) {
+            chain.push_back(successor);
+            successor = successor->left.get();
+        }
+        Snapshot right = successor->right;
+        for (size_t i = chain.size(); i-- > 0;) {
+            right = makeNode(chain[i]->entry, right, chain[i]->right);
+        }
+        child = makeNode(successor->entry, node->left, right);
+    }
+    for (size_t i = path.size(); i-- > 0;) {
+        const PersistentNode* parent = path[i];
+        child = strcasecmp(word.c_str(), parent->entry->word.c_str()) < 0
+                    ? makeNode(parent->entry, child, parent->right)
+                    : makeNode(parent->entry, parent->left, child);
+    }
+    return child;
+}
+
+static bool publish(PersistentDictionary* dictionary, const shared_ptr<const WordEntry>& entry, bool replace) {
+    lock_guard<mutex> lock(dictionary->writer);
+    Snapshot current = dictionary->root.load(memory_order_relaxed);
+    Snapshot updated = insertPath(dictionary, current, entry, replace);
+    if (updated == nullptr) {
+        return false;
+    }
+    dictionary->root.store(updated, memory_order_release);
+    return true;
+}
+
+// Returns false when the word already exists.
+bool addWord(PersistentDictionary* dictionary, WordEntry entry) {
+    return publish(dictionary, make_shared<const WordEntry>(move(entry)), false);
+}
+
+// Replaces the entry with the same word; returns false when it does not exist.
+bool modifyWord(PersistentDictionary* dictionary, WordEntry entry) {
+    return publish(dictionary, make_shared<const WordEntry>(move(entry)), true);
+}
+
+bool deleteWord(PersistentDictionary* dictionary, const string& word) {
+    lock_guard<mutex> lock(dictionary->writer);
+    bool deleted = false;
+    Snapshot current = dictionary->root.load(memory_order_relaxed);
+    Snapshot updated = deletePath(current, word, deleted);
+    if (!deleted) {
+        return false;
+    }
+    dictionary->size--;
+    if ((double) dictionary->size < balance * (double) dictionary->maxSize) {
+        updated = rebuildBalanced(updated);
+        dictionary->maxSize = dictionary->size;
+    }
+    dictionary->root.store(updated, memory_order_release);
+    return true;
+}
+
+// Same file format as the mutable dictionary; replaces the current version.
+int loadDictionary(PersistentDictionary* dictionary, istream& in) {
+    Dictionary staging;
+    staging.root = nullptr;
+    int loaded = loadDictionary(&staging, in);
+    vector<Node*> nodes;
+    flattenTree(staging.root, nodes);
+    vector<shared_ptr<const WordEntry>> entries;
+    entries.reserve(nodes.size());
+    for (Node* node : nodes) {
+        entries.push_back(make_shared<const WordEntry>(WordEntry{
+            move(node->word), move(node->meaning), move(node->grammaticalCategory),
+            {move(node->synonyms[0]), move(node->synonyms[1]), move(node->synonyms[2])}}));
+        delete node;
+    }
+    lock_guard<mutex> lock(dictionary->writer);
+    dictionary->root.store(buildBalanced(entries, 0, (int) entries.size() - 1), memory_order_release);
+    dictionary->size = entries.size();
+    dictionary->maxSize = entries.size();
+    return loaded;
+}
+
+const WordEntry* searchWord(const Snapshot& snapshot, const string& word) {
+    const PersistentNode* node = snapshot.get();
+    while (node != nullptr) {
+        int order = strcasecmp(word.c_str(), node->entry->word.c_str());
+        if (order == 0) {
+            return node->entry.get();
+        }
+        node = order < 0 ? node->left.get() : node->right.get();
+    }
+    return nullptr;
+}
+
+// In alphabetical order; the snapshot keeps every visited node alive.
+void forEachWord(const Snapshot& snapshot, const function<void(const WordEntry&)>& visit) {
+    vector<const PersistentNode*> stack;
+    const PersistentNode* current = snapshot.get();
+    while (current != nullptr || !stack.empty()) {
+        while (current != nullptr) {
+            stack.push_back(current);
+            current = current->left.get();
+        }
+        current = stack.back();
+        stack.pop_back();
+        visit(*current->entry);
+        current = current->right.get();
+    }
+}
+
+long countWords(const Snapshot& snapshot) {
+    long count = 0;
+    forEachWord(snapshot, [&count](const WordEntry&) { count++; });
+    return count;
+}
+
+void saveSnapshot(const Snapshot& snapshot, ostream& out) {
+    forEachWord(snapshot, [&out](const WordEntry& entry) { writeEntry(out, entry); });
+}
+
+static shared_ptr<const WordEntry> copyEntry(LazyStore* lazy, Node* node) {
+    return make_shared<const WordEntry>(readEntry(lazy, node));
+}
+
+void enableSnapshots(Dictionary* dictionary) {
+    if (dictionary->versions == nullptr) {
+        dictionary->versions = new PersistentDictionary();
+    }
+}
+
+// Snapshots already taken stay valid; they own the nodes they reference.
+void disableSnapshots(Dictionary* dictionary) {
+    delete dictionary->versions;
+    dictionary->versions = nullptr;
+}
+
+void recordVersion(Dictionary* dictionary, const string& word) {
+    PersistentDictionary* versions = dictionary->versions;
+    if (versions == nullptr || versions->stale) {
+        return;
+    }
+    // Past this many words one rebuild is cheaper than a path copy for each, and
+    // bulk loads stop growing the list.
+    if (versions->changed.size() >= versions->size / 8 + 16) {
+        versions->changed.clear();
+        versions->changed.shrink_to_fit();
+        versions->stale = true;
+        return;
+    }
+    versions->changed.push_back(word);
+}
+
+Snapshot takeSnapshot(Dictionary* dictionary) {
+    PersistentDictionary* versions = dictionary->versions;
+    if (versions->stale) {
+        vector<Node*> nodes;
+        flattenLiveTree(dictionary->root, nodes);
+        vector<shared_ptr<const WordEntry>> entries;
+        entries.reserve(nodes.size());
+        for (Node* node : nodes) {
+            entries.push_back(copyEntry(dictionary->lazy, node));
+        }
+        lock_guard<mutex> lock(versions->writer);
+        versions->root.store(buildBalanced(entries, 0, (int) entries.size() - 1), memory_order_release);
+        versions->size = entries.size();
+        versions->maxSize = entries.size();
+        versions->stale = false;
+    } else {
+        for (const string& word : versions->changed) {
+            Node* entry = findNode(dictionary->root, word);
+            if (entry == nullptr) {
+                deleteWord(versions, word);
+                continue;
+            }
+            shared_ptr<const WordEntry> copy = copyEntry(dictionary->lazy, entry);
+            if (!publish(versions, copy, true)) {
+                publish(versions, copy, false);
+            }
+        }
+        versions->changed.clear();
+    }
+    return takeSnapshot(versions);
+}
+
+void printSnapshotStats(const Dictionary* dictionary, ostream& out) {
+    if (dictionary->versions == nullptr) {
+        out << "Snapshots are disabled.\n";
+        return;
+    }
+    const PersistentDictionary* versions = dictionary->versions;
+    if (versions->stale) {
+        out << "Snapshots: the next one rebuilds the version from the tree\n";
+        return;
+    }
+    out << "Snapshots: " << versions->size << " words in the last version, " << versions->changed.size()
+        << " changed words to apply\n";
+}
@@ -0,0 +1,74 @@
+#ifndef PERSISTENT_H
+#define PERSISTENT_H
+
+#include <atomic>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "dictionary.h"
+
+/*
+Path-copying persistent variant of the dictionary tree. Nodes are immutable and
+shared between versions: a mutation copies only the nodes on the path from the
+root to the change and publishes a new root. takeSnapshot is a single atomic
+shared_ptr copy, readers iterate their snapshot without locks while writers
+continue, and nodes are freed when the last version that references them is released.
+Updates walk and rebuild their path iteratively, and the tree is kept scapegoat
+balanced (see scapegoat.h), so sorted inserts neither copy long paths nor recurse deeply.
+
+A Dictionary can keep one of these beside its tree (enableSnapshots). It is only
+brought up to date when a snapshot is taken: a change of the tree just notes the
+word, and takeSnapshot(Dictionary*) path-copies the noted words into the version,
+or rebuilds it from the tree after more changes than that is worth. The exports
+and backups, i.e. the batch list, save and freeze commands and checkpoint base
+files, then write from a snapshot taken when they start.
+*/
+
+struct PersistentNode {
+    std::shared_ptr<const WordEntry> entry;
+    std::shared_ptr<const PersistentNode> left;
+    std::shared_ptr<const PersistentNode> right;
+    // Releases a long chain without recursing once per node.
+    ~PersistentNode();
+};
+
+typedef std::shared_ptr<const PersistentNode> Snapshot;
+
+struct PersistentDictionary {
+    std::atomic<Snapshot> root;
+    std::mutex writer;
+    // Guarded by writer: the word count and the largest count since the last full rebuild.
+    size_t size = 0;
+    size_t maxSize = 0;
+    // Owned by the thread that changes the Dictionary: the words changed since root
+    // was brought up to date, or stale when root must be rebuilt from the tree.
+    std::vector<std::string> changed;
+    bool stale = true;
+};
+
+Snapshot takeSnapshot(PersistentDictionary* dictionary);
+bool addWord(PersistentDictionary* dictionary, WordEntry entry);
+bool modifyWord(PersistentDictionary* dictionary, WordEntry entry);
+bool deleteWord(PersistentDictionary* dictionary, const std::string& word);
+int loadDictionary(PersistentDictionary* dictionary, std::istream& in);
+
+const WordEntry* searchWord(const Snapshot& snapshot, const std::string& word);
+void forEachWord(const Snapshot& snapshot, const std::function<void(const WordEntry&)>& visit);
+long countWords(const Snapshot& snapshot);
+void saveSnapshot(const Snapshot& snapshot, std::ostream& out);
+
+void enableSnapshots(Dictionary* dictionary);
+void disableSnapshots(Dictionary* dictionary);
+// Notes that word changed in the tree; the version catches up on the next snapshot.
+void recordVersion(Dictionary* dictionary, const std::string& word);
+// Brings the version up to date with the tree and takes a snapshot of it. Call it
+// from the thread that changes the dictionary; snapshots must be enabled.
+Snapshot takeSnapshot(Dictionary* dictionary);
+void printSnapshotStats(const Dictionary* dictionary, std::ostream& out);
+
+#endif
@@ -0,0 +1,88 @@
+#include "scapegoat.h"
+
+#include <cmath>
+
+#include "dictionary.h"
+
+using namespace std;
+
+static size_t subtreeSize(Node* root) {
+    size_t size = 0;
+    vector<Node*> stack;
+    if (root != nullptr) {
+        stack.push_back(root);
+    }
+    while (!stack.empty()) {
+        Node* node = stack.back();
+        stack.pop_back();
+        size++;
+        if (node->left != nullptr) {
+            stack.push_back(node->left);
+        }
+        if (node->right != nullptr) {
+            stack.push_back(node->right);
+        }
+    }
+    return size;
+}
+
+static double heightLimit(const Dictionary* dictionary) {
+    return log((double) dictionary->size) / log(1.0 / dictionary->alpha);
+}
+
+void enableScapegoat(Dictionary* dictionary, double alpha) {
+    dictionary->alpha = alpha > 0.5 && alpha < 1 ? alpha : 0.7;
+    dictionary->size = subtreeSize(dictionary->root);
+    // Start from a balanced tree so the height bound holds from the first insert.
+    rebuildTree(dictionary);
+    dictionary->maxSize = dictionary->size;
+}
+
+void disableScapegoat(Dictionary* dictionary) {
+    dictionary->alpha = 0;
+}
+
+void scapegoatAfterInsert(Dictionary* dictionary, vector<Node**>& ancestors, Node* inserted) {
+    dictionary->size++;
+    if (dictionary->size > dictionary->maxSize) {
+        dictionary->maxSize = dictionary->size;
+    }
+    if ((double) ancestors.size() <= heightLimit(dictionary)) {
+        return;
+    }
+    // Subtree sizes are computed bottom-up, counting only the siblings off the path.
+    Node* child = inserted;
+    size_t childSize = 1;
+    for (size_t i = ancestors.size(); i-- > 0;) {
+        Node* node = *ancestors[i];
+        Node* sibling = node->left == child ? node->right : node->left;
+        size_t nodeSize = 1 + childSize + subtreeSize(sibling);
+        if ((double) childSize > dictionary->alpha * (double) nodeSize) {
+            vector<Node*> nodes;
+            nodes.reserve(nodeSize);
+            flattenTree(node, nodes);
+            *ancestors[i] = buildBalanced(nodes, 0, (int) nodes.size() - 1);
+            return;
+        }
+        child = node;
+        childSize = nodeSize;
+    }
+}
+
+void scapegoatAfterDelete(Dictionary* dictionary) {
+    dictionary->size--;
+    if ((double) dictionary->size < dictionary->alpha * (double) dictionary->maxSize) {
+        rebuildTree(dictionary);
+        dictionary->maxSize = dictionary->size;
+    }
+}
+
+void printScapegoatStats(const Dictionary* dictionary, ostream& out) {
+    if (dictionary->alpha == 0) {
+        out << "Scapegoat mode is disabled.\n";
+        return;
+    }
+    out << "Scapegoat mode: alpha " << dictionary->alpha << ", " << dictionary->size << " words, "
+        << dictionary->maxSize << " at most since the last full rebuild, height limit "
+        << (dictionary->size == 0 ? 0 : (int) heightLimit(dictionary) + 1) << "\n";
+}
@@ -0,0 +1,30 @@
+#ifndef SCAPEGOAT_H
+#define SCAPEGOAT_H
+
+#include <ostream>
+#include <vector>
+
+struct Dictionary;
+struct Node;
+
+/*
+Scapegoat balancing for the plain tree. Nodes carry no balance data; the dictionary
+keeps alpha, its word count and the largest count since the last full rebuild. An
+insert that lands deeper than log base 1/alpha of the word count walks back up its
+search path to the first ancestor whose child on the path holds more than alpha of
+its subtree, and rebuilds that subtree perfectly balanced in place. Once deletes
+shrink the dictionary below alpha times that largest count the whole tree is
+rebuilt. Both keep the height logarithmic with amortized O(log n) updates.
+Nodes are relinked, never copied, so the accelerators stay valid.
+*/
+
+// alpha must lie strictly between 0.5 and 1; smaller values keep the tree flatter
+// at the price of more frequent rebuilds.
+void enableScapegoat(Dictionary* dictionary, double alpha);
+void disableScapegoat(Dictionary* dictionary);
+// ancestors are the links followed from the root to the new node's parent.
+void scapegoatAfterInsert(Dictionary* dictionary, std::vector<Node**>& ancestors, Node* inserted);
+void scapegoatAfterDelete(Dictionary* dictionary);
+void printScapegoatStats(const Dictionary* dictionary, std::ostream& out);
+
+#endif
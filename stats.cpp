@@ -0,0 +1,143 @@
+#include "stats.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+using namespace std;
+
+#ifdef DICTIONARY_INSTRUMENTATION
+
+static const char* operationNames[STAT_OPERATIONS] = {
+    "insert", "search", "delete", "list_category", "list_letter", "list_all", "count"};
+
+// Bucket 0 holds zero, bucket b holds values in [2^(b-1), 2^b).
+static const int histogramBuckets = 65;
+
+struct StatHistogram {
+    atomic<uint64_t> buckets[histogramBuckets];
+    atomic<uint64_t> total;
+    atomic<uint64_t> max;
+};
+
+struct OperationStats {
+    atomic<uint64_t> count;
+    StatHistogram comparisons;
+    StatHistogram nodes;
+    StatHistogram depth;
+};
+
+thread_local StatProbe statProbe = {};
+static OperationStats operationStats[STAT_OPERATIONS];
+
+static int bucketOf(uint64_t value) {
+    return value == 0 ? 0 : 64 - __builtin_clzll(value);
+}
+
+static void recordValue(StatHistogram& histogram, uint64_t value) {
+    histogram.buckets[bucketOf(value)].fetch_add(1, memory_order_relaxed);
+    histogram.total.fetch_add(value, memory_order_relaxed);
+    uint64_t seen = histogram.max.load(memory_order_relaxed);
+    while (value > seen && !histogram.max.compare_exchange_weak(seen, value, memory_order_relaxed)) {
+    }
+}
+
+void finishStatOperation(StatOperation operation) {
+    OperationStats& stats = operationStats[operation];
+    stats.count.fetch_add(1, memory_order_relaxed);
+    recordValue(stats.comparisons, statProbe.comparisons);
+    recordValue(stats.nodes, statProbe.nodes);
+    recordValue(stats.depth, statProbe.maxDepth);
+}
+
+static void printHistogram(ostream& out, const char* name, const StatHistogram& histogram, uint64_t count) {
+    out << "  " << name << ": avg " << (double) histogram.total.load(memory_order_relaxed) / count
+        << ", max " << histogram.max.load(memory_order_relaxed) << ",";
+    for (int b = 0; b < histogramBuckets; b++) {
+        uint64_t n = histogram.buckets[b].load(memory_order_relaxed);
+        if (n == 0) {
+            continue;
+        }
+        uint64_t low = b == 0 ? 0 : 1ULL << (b - 1);
+        uint64_t high = b == 0 ? 0 : (b == 64 ? UINT64_MAX : (1ULL << b) - 1);
+        out << " [" << low << "-" << high << "]:" << n;
+    }
+    out << "\n";
+}
+
+void printStats(ostream& out) {
+    for (int op = 0; op < STAT_OPERATIONS; op++) {
+        const OperationStats& stats = operationStats[op];
+        uint64_t count = stats.count.load(memory_order_relaxed);
+        if (count == 0) {
+            continue;
+        }
+        out << operationNames[op] << ": " << count << " operations\n";
+        printHistogram(out, "comparisons", stats.comparisons, count);
+        printHistogram(out, "nodes visited", stats.nodes, count);
+        printHistogram(out, "max depth", stats.depth, count);
+    }
+}
+
+static void resetHistogram(StatHistogram& histogram) {
+    for (auto& bucket : histogram.buckets) {
+        bucket.store(0, memory_order_relaxed);
+    }
+    histogram.total.store(0, memory_order_relaxed);
+    histogram.max.store(0, memory_order_relaxed);
+}
+
+void resetStats() {
+    for (OperationStats& stats : operationStats) {
+        stats.count.store(0, memory_order_relaxed);
+        resetHistogram(stats.comparisons);
+        resetHistogram(stats.nodes);
+        resetHistogram(stats.depth);
+    }
+}
+
+#else
+
+void printStats(ostream& out) {
+    out << "Instrumentation is disabled (configure with -DDICTIONARY_INSTRUMENTATION=ON).\n";
+}
+
+void resetStats() {
+}
+
+#endif
+
+static mutex dumpMutex;
+static condition_variable dumpWake;
+static thread dumpThread;
+static bool dumpStopping = false;
+
+// Prints the statistics every intervalSeconds until stopStatsDump is called.
+void startStatsDump(int intervalSeconds, ostream& out) {
+    if (intervalSeconds <= 0 || dumpThread.joinable()) {
+        return;
+    }
+    dumpStopping = false;
+    dumpThread = thread([intervalSeconds, &out]() {
+        unique_lock<mutex> lock(dumpMutex);
+        while (!dumpWake.wait_for(lock, chrono::seconds(intervalSeconds), [] { return dumpStopping; })) {
+            out << "--- statistics ---\n";
+            printStats(out);
+            out.flush();
+        }
+    });
+}
+
+void stopStatsDump() {
+    if (!dumpThread.joinable()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(dumpMutex);
+        dumpStopping = true;
+    }
+    dumpWake.notify_all();
+    dumpThread.join();
+}
@@ -0,0 +1,98 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cstdint>
+#include <ostream>
+
+/*
+Hot-path instrumentation: per operation, the number of key comparisons, nodes
+visited and maximum depth reached, aggregated into log2 histograms.
+Only compiled in when DICTIONARY_INSTRUMENTATION is defined
+(cmake -DDICTIONARY_INSTRUMENTATION=ON); otherwise the macros expand to nothing.
+*/
+
+enum StatOperation {
+    STAT_INSERT,
+    STAT_SEARCH,
+    STAT_DELETE,
+    STAT_LIST_CATEGORY,
+    STAT_LIST_LETTER,
+    STAT_LIST_ALL,
+    STAT_COUNT,
+    STAT_OPERATIONS
+};
+
+void printStats(std::ostream& out);
+void resetStats();
+void startStatsDump(int intervalSeconds, std::ostream& out);
+void stopStatsDump();
+
+#ifdef DICTIONARY_INSTRUMENTATION
+
+struct StatProbe {
+    int nesting;
+    int depth;
+    uint64_t comparisons;
+    uint64_t nodes;
+    uint64_t maxDepth;
+};
+
+extern thread_local StatProbe statProbe;
+
+void finishStatOperation(StatOperation operation);
+
+// Placed at the top of every recursive tree function. Nested scopes of the same
+// operation are one more level of the same descent; the outermost one records it.
+class StatScope {
+public:
+    StatScope(StatOperation operation, const void* node) : operation(operation), counted(node != nullptr) {
+        if (statProbe.nesting++ == 0) {
+            statProbe.comparisons = 0;
+            statProbe.nodes = 0;
+            statProbe.maxDepth = 0;
+            statProbe.depth = 0;
+        }
+        if (counted) {
+            statProbe.nodes++;
+            statProbe.depth++;
+            if ((uint64_t) statProbe.depth > statProbe.maxDepth) {
+                statProbe.maxDepth = statProbe.depth;
+            }
+        }
+    }
+
+    ~StatScope() {
+        if (counted) {
+            statProbe.depth--;
+        }
+        if (--statProbe.nesting == 0) {
+            finishStatOperation(operation);
+        }
+    }
+
+private:
+    StatOperation operation;
+    bool counted;
+};
+
+// For iterative descents, which have no nested scopes to count levels.
+inline void statVisit(int depth) {
+    statProbe.nodes++;
+    if ((uint64_t) depth > statProbe.maxDepth) {
+        statProbe.maxDepth = depth;
+    }
+}
+
+#define STAT_SCOPE(operation, node) StatScope statScope(operation, node)
+#define STAT_COMPARE() (statProbe.comparisons++)
+#define STAT_VISIT(depth) statVisit(depth)
+
+#else
+
+#define STAT_SCOPE(operation, node) ((void) 0)
+#define STAT_COMPARE() ((void) 0)
+#define STAT_VISIT(depth) ((void) (depth))
+
+#endif
+
+#endif
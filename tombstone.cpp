@@ -0,0 +1,61 @@
+#include "tombstone.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "dictionary.h"
+#include "lazy.h"
+
+using namespace std;
+
+static uint64_t compactions = 0;
+
+void enableTombstones(Dictionary* dictionary, double ratio) {
+    dictionary->tombstoneRatio = ratio > 0 && ratio < 1 ? ratio : 0.25;
+    vector<Node*> nodes;
+    flattenTree(dictionary->root, nodes);
+    dictionary->size = nodes.size();
+}
+
+void disableTombstones(Dictionary* dictionary) {
+    if (dictionary->tombstones > 0) {
+        compactTombstones(dictionary);
+    }
+    dictionary->tombstoneRatio = 0;
+}
+
+void tombstoneAfterDelete(Dictionary* dictionary) {
+    dictionary->tombstones++;
+    if ((double) dictionary->tombstones > dictionary->tombstoneRatio * (double) dictionary->size) {
+        compactTombstones(dictionary);
+    }
+}
+
+void compactTombstones(Dictionary* dictionary) {
+    vector<Node*> nodes;
+    flattenTree(dictionary->root, nodes);
+    size_t live = 0;
+    for (Node* node : nodes) {
+        if (node->tombstone) {
+            forgetEntry(dictionary->lazy, node);
+            delete node;
+        } else {
+            nodes[live++] = node;
+        }
+    }
+    nodes.resize(live);
+    dictionary->root = buildBalanced(nodes, 0, (int) nodes.size() - 1);
+    dictionary->size = live;
+    dictionary->maxSize = live;
+    dictionary->tombstones = 0;
+    compactions++;
+}
+
+void printTombstoneStats(const Dictionary* dictionary, ostream& out) {
+    if (dictionary->tombstoneRatio == 0) {
+        out << "Tombstone mode is disabled.\n";
+        return;
+    }
+    out << "Tombstone mode: ratio " << dictionary->tombstoneRatio << ", " << dictionary->tombstones
+        << " tombstones among " << dictionary->size << " nodes, " << compactions << " compactions\n";
+}
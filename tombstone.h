@@ -0,0 +1,27 @@
+#ifndef TOMBSTONE_H
+#define TOMBSTONE_H
+
+#include <ostream>
+
+struct Dictionary;
+
+/*
+Tombstone deletes. While tombstone mode is on, deleteWord(Dictionary*, ...) only
+marks the word's node as a tombstone: no successor entry is copied and nothing is
+relinked, so a delete costs a lookup. searchWord, the iterators, counts, saves and
+the accelerators' rebuilds skip tombstones, and adding the word again revives its
+node in place. Once tombstones make up more than ratio of the linked nodes, the
+tree is compacted: their nodes are freed and the live ones relinked perfectly
+balanced, which keeps deletes amortized O(1) on top of the lookup. Live nodes are
+never moved or copied, so the hash index and hot cache stay valid.
+*/
+
+// ratio must lie strictly between 0 and 1.
+void enableTombstones(Dictionary* dictionary, double ratio);
+// Compacts away the remaining tombstones.
+void disableTombstones(Dictionary* dictionary);
+void tombstoneAfterDelete(Dictionary* dictionary);
+void compactTombstones(Dictionary* dictionary);
+void printTombstoneStats(const Dictionary* dictionary, std::ostream& out);
+
+#endif
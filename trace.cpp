@@ -0,0 +1,88 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "batch.h"
+
+using namespace std;
+
+void recordOperation(TraceRecorder* recorder, initializer_list<string> args) {
+    if (recorder == nullptr) {
+        return;
+    }
+    bool first = true;
+    for (const string& arg : args) {
+        if (!first) {
+            recorder->out << '\t';
+        }
+        recorder->out << arg;
+        first = false;
+    }
+    recorder->out << '\n';
+}
+
+/*
+Replays a batch trace as fast as possible with the dictionary's output discarded.
+The trace is read into memory first so file I/O is not timed. Prints count, total,
+mean, p50, p99 and max latency per command to report and, when latencies is set,
+one "line,command,nanoseconds" row per operation. Returns the number of invalid commands.
+*/
+int replayTrace(Dictionary* dictionary, istream& trace, ostream& report, ostream* latencies) {
+    vector<string> lines;
+    string line;
+    while (getline(trace, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        lines.push_back(line);
+    }
+
+    vector<uint64_t> elapsed(lines.size());
+    int failed = 0;
+    NullBuffer nullBuffer;
+    streambuf* original = cout.rdbuf(&nullBuffer);
+    auto begin = chrono::steady_clock::now();
+    for (size_t i = 0; i < lines.size(); i++) {
+        auto start = chrono::steady_clock::now();
+        bool ok = runCommand(dictionary, lines[i]);
+        auto stop = chrono::steady_clock::now();
+        elapsed[i] = (uint64_t) chrono::duration_cast<chrono::nanoseconds>(stop - start).count();
+        failed += ok ? 0 : 1;
+    }
+    double totalSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    cout.rdbuf(original);
+
+    map<string, vector<uint64_t>> byCommand;
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (lines[i].empty() || lines[i][0] == '#') {
+            continue;
+        }
+        string command = lines[i].substr(0, lines[i].find('\t'));
+        byCommand[command].push_back(elapsed[i]);
+        if (latencies != nullptr) {
+            *latencies << i + 1 << ',' << command << ',' << elapsed[i] << '\n';
+        }
+    }
+
+    report << "command,count,total_ns,mean_ns,p50_ns,p99_ns,max_ns\n";
+    for (auto& [command, samples] : byCommand) {
+        sort(samples.begin(), samples.end());
+        uint64_t total = 0;
+        for (uint64_t sample : samples) {
+            total += sample;
+        }
+        size_t count = samples.size();
+        report << command << ',' << count << ',' << total << ',' << total / count << ','
+               << samples[count / 2] << ',' << samples[min(count - 1, (size_t) (count * 0.99))] << ','
+               << samples.back() << '\n';
+    }
+    report << "# " << lines.size() << " operations in " << totalSeconds << " s ("
+           << (totalSeconds > 0 ? (uint64_t) (lines.size() / totalSeconds) : 0) << " ops/sec), "
+           << failed << " invalid\n";
+    return failed;
+}
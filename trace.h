@@ -0,0 +1,28 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <fstream>
+#include <initializer_list>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include "dictionary.h"
+
+// Discards everything written to it, for timing code that prints.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+// Writes the operations of an interactive session as batch commands.
+struct TraceRecorder {
+    std::ofstream out;
+};
+
+void recordOperation(TraceRecorder* recorder, std::initializer_list<std::string> args);
+int replayTrace(Dictionary* dictionary, std::istream& trace, std::ostream& report, std::ostream* latencies);
+
+#endif